@@ -0,0 +1,61 @@
+/*
+Time: 2026-10-16
+Test: square() and x *= x.
+std Time: 0.02s
+Time Limit: 1.00s
+Notes: Self-checking. Sizes cross every multiplication tier.
+*/
+
+#include "int2048.h"
+
+using sjtu::int2048;
+
+static unsigned long long state = 88172645463325252ull;
+
+static std::string digits(int n, bool negative) {
+    std::string s = negative ? "-" : "";
+    for (int i = 0; i < n; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        s += char((i == 0 ? '1' + state % 9 : '0' + state % 10));
+    }
+    return s;
+}
+
+static int failures = 0;
+
+static void check(bool ok, const std::string &what) {
+    std::cout << what << (ok ? ": ok" : ": FAIL") << '\n';
+    if (!ok) ++failures;
+}
+
+signed main() {
+    check(sjtu::square(int2048(0)) == int2048(0), "square(0)");
+    check(sjtu::square(int2048(-3)) == int2048(9), "square(-3)");
+    check(sjtu::square(int2048(-99999)) == int2048(9999800001ll), "square(-99999)");
+
+    // (10^n - 1)^2 = 9...98 0...01
+    for (int n : {9, 100, 1000, 20000}) {
+        std::string nines(n, '9'), expect = std::string(n - 1, '9') + "8" + std::string(n - 1, '0') + "1";
+        int2048 x(nines);
+        check(sjtu::square(x) == int2048(expect), "square(10^" + std::to_string(n) + " - 1)");
+    }
+
+    // x^2 = (x + 1)(x - 1) + 1, the right side through general products
+    for (int n : {1, 9, 50, 300, 2000, 10000, 60000}) {
+        for (bool negative : {false, true}) {
+            int2048 x(digits(n, negative));
+            int2048 expect = (x + 1) * (x - 1) + 1;
+            int2048 y = x;
+            y *= y;
+            int2048 z = x;
+            z.square();
+            std::string tag = std::to_string(n) + (negative ? " digits, negative" : " digits");
+            check(sjtu::square(x) == expect, "square(x), " + tag);
+            check(y == expect, "x *= x, " + tag);
+            check(z == expect, "x.square(), " + tag);
+        }
+    }
+    return failures != 0;
+}
@@ -0,0 +1,114 @@
+/*
+Time: 2026-10-16
+Test: divmod() with big and machine-word divisors.
+std Time: 0.45s
+Time Limit: 2.00s
+Notes: Self-checking. Floor semantics for every sign; sizes reach the
+       recursive and Newton divisions.
+*/
+
+#include "int2048.h"
+#include <climits>
+
+using sjtu::int2048;
+
+static unsigned long long state = 88172645463325252ull;
+
+static std::string digits(int n, bool negative) {
+    std::string s = negative ? "-" : "";
+    for (int i = 0; i < n; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        s += char((i == 0 ? '1' + state % 9 : '0' + state % 10));
+    }
+    return s;
+}
+
+static int failures = 0;
+
+static void check(bool ok, const std::string &what) {
+    std::cout << what << (ok ? ": ok" : ": FAIL") << '\n';
+    if (!ok) ++failures;
+}
+
+// q * b + r == a with r on the side of b, |r| < |b|
+static bool floorPair(const int2048 &a, const int2048 &b, const int2048 &q, const int2048 &r) {
+    int2048 zero;
+    bool inRange = b > zero ? zero <= r && r < b : b < r && r <= zero;
+    return inRange && q * b + r == a;
+}
+
+static long long floorDiv(long long a, long long b) {
+    long long q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+signed main() {
+    // Every sign combination of small operands, against floor division
+    bool small = true;
+    for (long long a : {7ll, -7ll, 6ll, -6ll, 1ll, -1ll, 0ll}) {
+        for (long long b : {2ll, -2ll, 3ll, -3ll, 7ll, -7ll, 1ll, -1ll}) {
+            long long fq = floorDiv(a, b), fr = a - fq * b;
+            int2048 q, r;
+            long long rw;
+            sjtu::divmod(int2048(a), int2048(b), q, r);
+            small = small && q == int2048(fq) && r == int2048(fr);
+            sjtu::divmod(int2048(a), b, q, rw);
+            small = small && q == int2048(fq) && rw == fr;
+            small = small && int2048(a) / int2048(b) == int2048(fq) && int2048(a) % int2048(b) == int2048(fr);
+        }
+    }
+    check(small, "small operands, all signs");
+
+    // Big divisors from one limb up to the Newton threshold
+    int sizes[][2] = {{30, 12}, {300, 9}, {2000, 1000}, {5000, 2500}, {20000, 4000},
+                      {60000, 30000}, {300000, 150000}};
+    for (auto &sz : sizes) {
+        for (int signs = 0; signs < 4; ++signs) {
+            int2048 a(digits(sz[0], signs & 1)), b(digits(sz[1], signs & 2));
+            int2048 q, r;
+            sjtu::divmod(a, b, q, r);
+            std::string tag = std::to_string(sz[0]) + " / " + std::to_string(sz[1]) + " digits, signs " +
+                              (signs & 1 ? "-" : "+") + (signs & 2 ? "-" : "+");
+            check(floorPair(a, b, q, r) && q == a / b && r == a % b, tag);
+        }
+    }
+
+    // Exact quotients leave a zero remainder
+    {
+        int2048 b(digits(3000, true)), c(digits(5000, false)), q, r;
+        sjtu::divmod(b * c, b, q, r);
+        check(q == c && r == int2048(0), "exact quotient");
+    }
+
+    // Outputs aliasing the operands
+    {
+        int2048 a(digits(4000, true)), b(digits(1500, false));
+        int2048 q = a / b, r = a % b;
+        int2048 x = a, y = b;
+        sjtu::divmod(x, y, x, y);
+        bool ok = x == q && y == r;
+        x = a;
+        y = b;
+        sjtu::divmod(x, y, y, x);
+        ok = ok && y == q && x == r;
+        check(ok, "outputs aliasing the operands");
+    }
+
+    // Machine-word divisors, the extremes included
+    for (long long b : {1ll, -1ll, 7ll, -7ll, 999999999ll, -1000000000ll, 1ll << 40, LLONG_MAX, LLONG_MIN}) {
+        bool ok = true;
+        for (int n : {1, 20, 400, 30000}) {
+            for (bool negative : {false, true}) {
+                int2048 a(digits(n, negative)), q;
+                long long r;
+                sjtu::divmod(a, b, q, r);
+                ok = ok && floorPair(a, int2048(b), q, int2048(r)) && q == a / b && int2048(r) == a % b;
+                ok = ok && q == a / int2048(b);
+            }
+        }
+        check(ok, "word divisor " + std::to_string(b));
+    }
+    return failures != 0;
+}
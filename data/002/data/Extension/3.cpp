@@ -0,0 +1,94 @@
+/*
+Time: 2026-10-16
+Test: int2048::Arena scopes.
+std Time: 0.20s
+Time Limit: 1.00s
+Notes: Self-checking. Values built inside a scope must stay valid after it
+       ends, including across nested and repeated scopes.
+*/
+
+#include "int2048.h"
+
+using sjtu::int2048;
+
+static unsigned long long state = 88172645463325252ull;
+
+static std::string digits(int n, bool negative) {
+    std::string s = negative ? "-" : "";
+    for (int i = 0; i < n; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        s += char((i == 0 ? '1' + state % 9 : '0' + state % 10));
+    }
+    return s;
+}
+
+static int failures = 0;
+
+static void check(bool ok, const std::string &what) {
+    std::cout << what << (ok ? ": ok" : ": FAIL") << '\n';
+    if (!ok) ++failures;
+}
+
+// A batch that allocates and frees blocks of many size classes
+static int2048 batch(const std::vector<int2048> &in) {
+    int2048 sum;
+    for (size_t i = 0; i + 1 < in.size(); ++i) {
+        int2048 p = in[i] * in[i + 1];
+        sum += p / (in[i] + 1);
+        sum -= p % 1000000007ll;
+    }
+    return sum;
+}
+
+signed main() {
+    std::vector<int2048> in;
+    for (int n : {5, 40, 300, 2000, 9000, 30000, 12, 700}) in.push_back(int2048(digits(n, n % 3 == 0)));
+    int2048 expect = batch(in);
+
+    // Results leave the scope and outlive it
+    int2048 inside;
+    std::vector<int2048> kept;
+    {
+        int2048::Arena arena;
+        inside = batch(in);
+        for (size_t i = 0; i < in.size(); ++i) kept.push_back(in[i] * in[i]);
+    }
+    check(inside == expect, "result assigned out of a scope");
+    bool ok = true;
+    for (size_t i = 0; i < in.size(); ++i) ok = ok && kept[i] == in[i] * in[i];
+    check(ok, "values kept after the scope");
+
+    // Nested scopes; the inner one ends first and its values stay too
+    {
+        int2048::Arena outer;
+        int2048 a = batch(in), b;
+        {
+            int2048::Arena inner;
+            b = batch(in);
+            kept.assign(in.begin(), in.end());
+        }
+        check(a == expect && b == expect, "nested scopes");
+        int2048 c = batch(in);
+        check(c == expect, "work after the inner scope");
+    }
+    ok = true;
+    for (size_t i = 0; i < in.size(); ++i) ok = ok && kept[i] == in[i];
+    check(ok, "values copied in an inner scope");
+
+    // Many short scopes, each releasing the cache as it ends
+    ok = true;
+    int2048 moved;
+    for (int round = 0; round < 50; ++round) {
+        int2048::Arena arena;
+        int2048 x = batch(in);
+        ok = ok && x == expect;
+        moved = std::move(x);
+    }
+    check(ok && moved == expect, "repeated scopes");
+
+    // The pool behaves the same once every scope has ended
+    check(batch(in) == expect, "after all scopes");
+    return failures != 0;
+}
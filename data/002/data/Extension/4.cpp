@@ -0,0 +1,82 @@
+/*
+Time: 2026-10-16
+Test: lazy() sums of products.
+std Time: 0.02s
+Time Limit: 1.00s
+Notes: Self-checking against the same expressions with plain operators.
+       Chains run past the eight terms a Sum holds before it collapses.
+*/
+
+#include "int2048.h"
+
+using sjtu::int2048;
+using sjtu::lazy;
+
+static unsigned long long state = 88172645463325252ull;
+
+static std::string digits(int n, bool negative) {
+    std::string s = negative ? "-" : "";
+    for (int i = 0; i < n; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        s += char((i == 0 ? '1' + state % 9 : '0' + state % 10));
+    }
+    return s;
+}
+
+static int failures = 0;
+
+static void check(bool ok, const std::string &what) {
+    std::cout << what << (ok ? ": ok" : ": FAIL") << '\n';
+    if (!ok) ++failures;
+}
+
+// Operands of n digits on average, of mixed signs and lengths
+static void run(int n) {
+    std::vector<int2048> v;
+    for (int i = 0; i < 12; ++i) v.push_back(int2048(digits(n + (i * 37) % (n / 4 + 1), i % 3 == 1)));
+    std::string tag = ", " + std::to_string(n) + " digits";
+
+    int2048 r = lazy(v[0]) * v[1] + v[2] - v[3];
+    check(r == v[0] * v[1] + v[2] - v[3], "short chain" + tag);
+
+    // Twelve plain terms
+    r = lazy(v[0]) + v[1] - v[2] + v[3] - v[4] + v[5] + v[6] - v[7] + v[8] - v[9] - v[10] + v[11];
+    check(r == v[0] + v[1] - v[2] + v[3] - v[4] + v[5] + v[6] - v[7] + v[8] - v[9] - v[10] + v[11],
+          "12 plain terms" + tag);
+
+    // Ten products
+    r = lazy(v[0]) * v[1] + lazy(v[2]) * v[3] - lazy(v[4]) * v[5] + lazy(v[6]) * v[7] - lazy(v[8]) * v[9] +
+        lazy(v[10]) * v[11] - lazy(v[1]) * v[2] + lazy(v[3]) * v[4] + lazy(v[5]) * v[6] - lazy(v[7]) * v[8];
+    check(r == v[0] * v[1] + v[2] * v[3] - v[4] * v[5] + v[6] * v[7] - v[8] * v[9] + v[10] * v[11] -
+                   v[1] * v[2] + v[3] * v[4] + v[5] * v[6] - v[7] * v[8],
+          "10 products" + tag);
+
+    // Products and plain terms mixed, 16 terms
+    r = lazy(v[0]) * v[1] - v[2] + v[3] + lazy(v[4]) * v[5] - v[6] - v[7] + lazy(v[8]) * v[9] + v[10] -
+        v[11] + lazy(v[0]) * v[0] - v[1] + v[2] - lazy(v[3]) * v[11] + v[4];
+    check(r == v[0] * v[1] - v[2] + v[3] + v[4] * v[5] - v[6] - v[7] + v[8] * v[9] + v[10] - v[11] +
+                   v[0] * v[0] - v[1] + v[2] - v[3] * v[11] + v[4],
+          "16 mixed terms" + tag);
+
+    // A Sum on the right, negated, and multiplied as a whole
+    r = v[0] - (lazy(v[1]) * v[2] - v[3]);
+    check(r == v[0] - (v[1] * v[2] - v[3]), "Sum on the right" + tag);
+    r = (lazy(v[0]) + v[1] - v[2]) * v[3] + v[4];
+    check(r == (v[0] + v[1] - v[2]) * v[3] + v[4], "Sum times a value" + tag);
+    r = v[5] * lazy(v[6]) * v[7] - v[8];
+    check(r == v[5] * v[6] * v[7] - v[8], "three factors" + tag);
+
+    // Terms that cancel to zero, and the destination among the operands
+    r = lazy(v[0]) * v[1] - v[1] * v[0] + v[2] - v[2];
+    check(r == int2048(0), "cancelling terms" + tag);
+    int2048 x = v[0], expect = v[0] * v[1] + v[0] - v[2];
+    x = lazy(x) * v[1] + x - v[2];
+    check(x == expect, "destination as an operand" + tag);
+}
+
+signed main() {
+    for (int n : {1, 9, 40, 300, 2000, 12000}) run(n);
+    return failures != 0;
+}
@@ -0,0 +1,95 @@
+/*
+Time: 2026-10-16
+Test: addmul() and submul().
+std Time: 0.02s
+Time Limit: 1.00s
+Notes: Self-checking, including an accumulator that is also a factor.
+*/
+
+#include "int2048.h"
+#include <climits>
+
+using sjtu::int2048;
+
+static unsigned long long state = 88172645463325252ull;
+
+static std::string digits(int n, bool negative) {
+    std::string s = negative ? "-" : "";
+    for (int i = 0; i < n; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        s += char((i == 0 ? '1' + state % 9 : '0' + state % 10));
+    }
+    return s;
+}
+
+static int failures = 0;
+
+static void check(bool ok, const std::string &what) {
+    std::cout << what << (ok ? ": ok" : ": FAIL") << '\n';
+    if (!ok) ++failures;
+}
+
+signed main() {
+    int sizes[][3] = {{1, 1, 1},      {30, 5, 7},        {10, 300, 40},      {300, 200, 250},
+                      {3000, 50, 2000}, {9000, 9000, 100}, {100, 12000, 12000}, {40000, 20000, 1}};
+    for (auto &sz : sizes) {
+        for (int signs = 0; signs < 8; signs += 3) {
+            int2048 acc(digits(sz[0], signs & 1)), a(digits(sz[1], signs & 2)), b(digits(sz[2], signs & 4));
+            std::string tag = ", " + std::to_string(sz[0]) + "/" + std::to_string(sz[1]) + "/" +
+                              std::to_string(sz[2]) + " digits, signs " + std::to_string(signs);
+            int2048 x = acc;
+            sjtu::addmul(x, a, b);
+            check(x == acc + a * b, "addmul" + tag);
+            x = acc;
+            sjtu::submul(x, a, b);
+            check(x == acc - a * b, "submul" + tag);
+
+            // The accumulator as one factor or both
+            x = acc;
+            sjtu::addmul(x, x, b);
+            bool ok = x == acc + acc * b;
+            x = acc;
+            sjtu::addmul(x, a, x);
+            ok = ok && x == acc + a * acc;
+            x = acc;
+            sjtu::submul(x, x, x);
+            ok = ok && x == acc - acc * acc;
+            x = acc;
+            sjtu::addmul(x, x, -7ll);
+            ok = ok && x == acc * -6;
+            check(ok, "accumulator as a factor" + tag);
+
+            // Back to the start: acc + a * b - a * b
+            x = acc;
+            sjtu::addmul(x, a, b);
+            sjtu::submul(x, b, a);
+            check(x == acc, "addmul then submul" + tag);
+        }
+    }
+
+    // Machine-word factors, the extremes included
+    bool ok = true;
+    for (long long k : {0ll, 1ll, -1ll, 999999999ll, -1000000000ll, 1ll << 50, LLONG_MAX, LLONG_MIN}) {
+        for (int n : {1, 20, 400, 5000}) {
+            int2048 acc(digits(n + 3, n % 2)), a(digits(n, false)), x = acc;
+            sjtu::addmul(x, a, k);
+            ok = ok && x == acc + a * int2048(k);
+            x = acc;
+            sjtu::submul(x, -a, k);
+            ok = ok && x == acc + a * int2048(k);
+        }
+    }
+    check(ok, "word factors");
+
+    // Zero accumulator and zero factors
+    int2048 zero, a(digits(500, true)), x;
+    sjtu::addmul(x, a, zero);
+    ok = x == zero;
+    sjtu::submul(x, a, a);
+    ok = ok && x == -(a * a);
+    sjtu::addmul(x, a, a);
+    check(ok && x == zero, "zero accumulator and factors");
+    return failures != 0;
+}
@@ -0,0 +1,75 @@
+/*
+Time: 2026-10-16
+Test: to_chars() and to_string().
+std Time: 0.01s
+Time Limit: 1.00s
+Notes: Self-checking. Round trips through the string constructor, exact
+       and short buffers.
+*/
+
+#include "int2048.h"
+
+using sjtu::int2048;
+
+static unsigned long long state = 88172645463325252ull;
+
+static std::string digits(int n, bool negative) {
+    std::string s = negative ? "-" : "";
+    for (int i = 0; i < n; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        s += char((i == 0 ? '1' + state % 9 : '0' + state % 10));
+    }
+    return s;
+}
+
+static int failures = 0;
+
+static void check(bool ok, const std::string &what) {
+    std::cout << what << (ok ? ": ok" : ": FAIL") << '\n';
+    if (!ok) ++failures;
+}
+
+// to_string() gives back s, and to_chars() writes it into a buffer of exactly
+// its length but not into one a character shorter
+static bool roundTrip(const int2048 &x, const std::string &s) {
+    if (x.to_string() != s || x.to_chars_bound() < s.size()) return false;
+    std::vector<char> buf(x.to_chars_bound() + 1, '#');
+    char *end = x.to_chars(buf.data(), buf.data() + buf.size());
+    if (!end || std::string(buf.data(), end) != s || *end != '#') return false;
+    end = x.to_chars(buf.data(), buf.data() + s.size());
+    if (end != buf.data() + s.size()) return false;
+    return x.to_chars(buf.data(), buf.data() + s.size() - 1) == nullptr;
+}
+
+signed main() {
+    check(roundTrip(int2048(), "0"), "default value");
+    check(roundTrip(int2048("-0000"), "0"), "negative zero");
+    check(roundTrip(int2048("000123"), "123"), "leading zeros");
+    check(roundTrip(int2048(-1000000000ll), "-1000000000"), "-10^9");
+    check(roundTrip(int2048(9223372036854775807ll), "9223372036854775807"), "LLONG_MAX");
+    check(roundTrip(int2048(-9223372036854775807ll - 1), "-9223372036854775808"), "LLONG_MIN");
+
+    // Powers of ten and their neighbours land on limb boundaries
+    bool ok = true;
+    for (int n = 1; n <= 40; ++n) {
+        std::string p = "1" + std::string(n, '0'), q(n, '9');
+        ok = ok && roundTrip(int2048(p), p) && roundTrip(int2048(q), q) && roundTrip(-int2048(p), "-" + p);
+    }
+    check(ok, "powers of ten");
+
+    for (int n : {5, 9, 10, 64, 577, 4000, 30000, 100000}) {
+        for (bool negative : {false, true}) {
+            std::string s = digits(n, negative);
+            check(roundTrip(int2048(s), s), std::to_string(n) + (negative ? " digits, negative" : " digits"));
+        }
+    }
+
+    // Inner limbs that are zero must keep their padding
+    std::string s = "7" + std::string(100, '0') + "1" + std::string(50, '0');
+    std::string square = "49" + std::string(99, '0') + "14" + std::string(100, '0') + "1" + std::string(100, '0');
+    int2048 x(s);
+    check(roundTrip(x, s) && roundTrip(x * x, square), "zero limbs inside");
+    return failures != 0;
+}
@@ -0,0 +1,119 @@
+/*
+Time: 2026-10-16
+Test: read_all() across its 1 MiB read blocks.
+std Time: 0.18s
+Time Limit: 1.00s
+Notes: Self-checking. Writes its input to a temporary file so that tokens,
+       signs and whitespace land exactly on the block boundaries.
+*/
+
+#include "int2048.h"
+
+using sjtu::int2048;
+
+static const long BLOCK = 1 << 20;
+
+static unsigned long long state = 88172645463325252ull;
+
+static std::string digits(int n, bool negative) {
+    std::string s = negative ? "-" : "";
+    for (int i = 0; i < n; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        s += char((i == 0 ? '1' + state % 9 : '0' + state % 10));
+    }
+    return s;
+}
+
+static int failures = 0;
+
+static void check(bool ok, const std::string &what) {
+    std::cout << what << (ok ? ": ok" : ": FAIL") << '\n';
+    if (!ok) ++failures;
+}
+
+// Appends short tokens with assorted whitespace between them, then spaces
+// until text is exactly `at` bytes long
+static void fill(std::string &text, std::vector<std::string> &tokens, long at) {
+    static const char *gaps[] = {" ", "\n", "\t", "  ", "\r\n"};
+    while ((long)text.size() + 40 < at) {
+        tokens.push_back(digits(1 + (int)(state % 25), state % 4 == 0));
+        text += tokens.back();
+        text += gaps[state % 5];
+    }
+    text.append(at - text.size(), ' ');
+}
+
+// Reads text back through a file and compares the values with tokens; the
+// vector starts non-empty to check that read_all() appends.
+static bool readBack(const std::string &text, const std::vector<std::string> &tokens) {
+    std::FILE *f = std::tmpfile();
+    if (!f) return false;
+    std::fwrite(text.data(), 1, text.size(), f);
+    std::rewind(f);
+    std::vector<int2048> out(1, int2048(42));
+    size_t n = sjtu::read_all(f, out);
+    std::fclose(f);
+    if (n != tokens.size() || out.size() != tokens.size() + 1 || out[0] != int2048(42)) return false;
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        if (out[i + 1] != int2048(tokens[i])) return false;
+    }
+    return true;
+}
+
+// A token placed so that it starts `offset` bytes from the block boundary
+static void across(int offset, const std::string &token, const std::string &what) {
+    std::string text;
+    std::vector<std::string> tokens;
+    fill(text, tokens, BLOCK + offset);
+    text += token;
+    tokens.push_back(token);
+    text += '\n';
+    fill(text, tokens, text.size() + 100);
+    check(readBack(text, tokens), what);
+}
+
+signed main() {
+    check(readBack("", {}), "empty input");
+    check(readBack(" \n\t \n", {}), "whitespace only");
+    check(readBack("-12 0 +7 000123\n-0", {"-12", "0", "7", "123", "0"}), "small input without a final newline");
+
+    across(-10, digits(30, false), "token across the boundary");
+    across(-1, digits(30, true), "sign as the last byte of the block");
+    across(-30, digits(30, false), "token ending at the boundary");
+    across(0, digits(30, true), "token starting at the boundary");
+    across(-5000, digits(20000, true), "long token across the boundary");
+
+    // Whitespace across the boundary, and a file of exactly one block
+    {
+        std::string text;
+        std::vector<std::string> tokens;
+        fill(text, tokens, BLOCK - 3);
+        text += "      ";
+        tokens.push_back("-987654321987654321");
+        text += tokens.back();
+        check(readBack(text, tokens), "whitespace across the boundary");
+
+        text.clear();
+        tokens.clear();
+        fill(text, tokens, BLOCK - 20);
+        tokens.push_back(digits(19, false));
+        text += tokens.back() + "\n";
+        check(text.size() == (size_t)BLOCK && readBack(text, tokens), "input of exactly one block");
+    }
+
+    // A token longer than a block, which the buffer has to grow for
+    {
+        std::string text;
+        std::vector<std::string> tokens;
+        fill(text, tokens, 1000);
+        tokens.push_back(digits(1200000, true));
+        text += tokens.back() + " ";
+        tokens.push_back(digits(10, false));
+        text += tokens.back() + "\n";
+        fill(text, tokens, 3 * BLOCK + 500);
+        check(readBack(text, tokens), "token longer than a block");
+    }
+    return failures != 0;
+}
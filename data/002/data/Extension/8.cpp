@@ -0,0 +1,102 @@
+/*
+Time: 2026-10-16
+Test: int2048_accumulator.
+std Time: 0.02s
+Time Limit: 1.00s
+Notes: Self-checking against a running sum kept with += and -=.
+*/
+
+#include "int2048.h"
+#include <climits>
+
+using sjtu::int2048;
+using sjtu::int2048_accumulator;
+
+static unsigned long long state = 88172645463325252ull;
+
+static unsigned long long next() {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+static std::string digits(int n, bool negative) {
+    std::string s = negative ? "-" : "";
+    for (int i = 0; i < n; ++i) {
+        next();
+        s += char((i == 0 ? '1' + state % 9 : '0' + state % 10));
+    }
+    return s;
+}
+
+static int failures = 0;
+
+static void check(bool ok, const std::string &what) {
+    std::cout << what << (ok ? ": ok" : ": FAIL") << '\n';
+    if (!ok) ++failures;
+}
+
+signed main() {
+    int2048_accumulator acc;
+    check(acc.finalize() == int2048(0), "empty accumulator");
+
+    // Mixed lengths, signs and word values; finalize() part-way and go on
+    int2048 expect;
+    bool ok = true;
+    for (int i = 0; i < 20000; ++i) {
+        unsigned long long r = next();
+        if (r % 5 == 0) {
+            long long v = (long long)next();
+            if (r % 2) {
+                acc += v;
+                expect += v;
+            } else {
+                acc -= v;
+                expect -= v;
+            }
+        } else {
+            int n = r % 7 == 0 ? 1 + (int)(next() % 3000) : 1 + (int)(next() % 40);
+            int2048 x(digits(n, r % 3 == 0));
+            if (r % 2) {
+                acc += x;
+                expect += x;
+            } else {
+                acc -= x;
+                expect -= x;
+            }
+        }
+        if (i % 4000 == 3999) ok = ok && acc.finalize() == expect;
+    }
+    check(ok && acc.finalize() == expect, "20000 mixed terms");
+
+    // The sum fed back in, then cancelled back to zero
+    int2048 total = acc.finalize();
+    acc += total;
+    ok = acc.finalize() == total * 2;
+    acc -= total;
+    acc -= total;
+    acc -= total;
+    check(ok && acc.finalize() == -total, "sum fed back in");
+    acc += total;
+    check(acc.finalize() == int2048(0), "cancelled to zero");
+
+    // clear() starts over; long long extremes and negative results
+    acc.clear();
+    check(acc.finalize() == int2048(0), "clear");
+    acc += LLONG_MIN;
+    acc += LLONG_MIN;
+    acc -= LLONG_MAX;
+    check(acc.finalize() == int2048(LLONG_MIN) * 2 - int2048(LLONG_MAX), "long long extremes");
+
+    // Borrows running through many limbs: 10^k - 1 from 10^k
+    acc.clear();
+    for (int k : {1, 9, 10, 100, 5000}) {
+        int2048 p("1" + std::string(k, '0'));
+        acc += p;
+        acc -= p - 1;
+    }
+    acc -= 5;
+    check(acc.finalize() == int2048(0), "long borrow chains");
+    return failures != 0;
+}
@@ -17,22 +17,135 @@
 
 // Do not use "using namespace std;"
 
+// Decimal digits per limb, 5 or 9. Nine-digit limbs almost halve the number
+// of limbs every pass has to touch; large products then need a third NTT
+// prime.
+#ifndef SJTU_INT2048_WIDTH
+#define SJTU_INT2048_WIDTH 9
+#endif
+
+// Defining SJTU_INT2048_BINARY switches to binary limbs of 30 bits instead:
+// every division by BASE becomes a shift, and read() and operator<< convert
+// by divide and conquer on top of the fast multiplication and division.
+
+// Defining SJTU_INT2048_THREADS (and linking with -pthread) lets very large
+// NTT products spread their transforms, CRT and carries over all hardware
+// threads, through a pool started on first use. Only the implementation file
+// then needs <thread>, <mutex> and <condition_variable>. Giving it a value
+// n > 1 (SJTU_INT2048_THREADS=8) uses n threads whatever the hardware has.
+
+// SJTU_INT2048_SIMD=1, 8 or 16 caps the vector kernels at scalar code, AVX2
+// or AVX-512 lanes; by default the widest the CPU supports is used, and a
+// cap above that has no effect.
+
 namespace sjtu {
 class int2048 {
 private:
-  static const int BASE = 100000;
-  static const int WIDTH = 5;
+#ifdef SJTU_INT2048_BINARY
+  static const bool BINARY = true;
+#else
+  static const bool BINARY = false;
+#endif
+  // Decimal digits per limb, or per conversion chunk with binary limbs.
+  static const int WIDTH = BINARY ? 9 : SJTU_INT2048_WIDTH;
+  static const int CHUNK = WIDTH == 9 ? 1000000000 : 100000; // 10^WIDTH
+  static const int BASE = BINARY ? 1 << 30 : CHUNK;
+  static_assert(WIDTH == 5 || WIDTH == 9, "SJTU_INT2048_WIDTH must be 5 or 9");
+
+  // Limb storage holding up to INLINE limbs inside the object itself, so small
+  // values never touch the heap; a subset of the std::vector interface.
+  class Limbs {
+  public:
+    static const int INLINE = 4;
+
+    Limbs();
+    explicit Limbs(size_t); // zero-filled
+    Limbs(const Limbs &);
+    Limbs(Limbs &&) noexcept;
+    ~Limbs();
+    Limbs &operator=(const Limbs &);
+    Limbs &operator=(Limbs &&) noexcept;
+
+    size_t size() const;
+    bool empty() const;
+    int *data();
+    const int *data() const;
+    int *begin();
+    const int *begin() const;
+    int *end();
+    const int *end() const;
+    int &operator[](size_t);
+    const int &operator[](size_t) const;
+    int &back();
+    const int &back() const;
+
+    void clear();
+    void pop_back();
+    void push_back(int);
+    void reserve(size_t);
+    void resize(size_t, int = 0);
+    void assign(size_t, int);
+    void assign(const int *, const int *);
+    void swap(Limbs &) noexcept;
+
+    bool operator==(const Limbs &) const;
+
+  private:
+    static int *allocate(size_t &);
+    static void release(int *, size_t);
+
+    int *p; // buf or a pooled block of cap limbs
+    unsigned n, cap;
+    int buf[INLINE];
+  };
 
   // sign == true means negative
   bool sign;
-  std::vector<int> d; // little-endian in BASE
+  Limbs d; // little-endian in BASE
 
   void trim();
+  int2048 &addSigned(const int2048 &, bool); // *this += (negate ? -o : o)
+  void mulAcc(const int2048 &, const int2048 &, bool); // *this += (negate ? -a : a) * b
   static int absCmp(const int2048 &, const int2048 &);
-  static int2048 absAdd(const int2048 &, const int2048 &);
   static int2048 absSub(const int2048 &, const int2048 &); // requires |a| >= |b|
   static int2048 absMulInt(const int2048 &, int);
+  static unsigned long long absDivInt(const int2048 &, unsigned long long, int2048 &);
   static void divModAbs(const int2048 &, const int2048 &, int2048 &, int2048 &);
+  static void divSchoolbook(const int2048 &, const int2048 &, int2048 &, int2048 &);
+  static void divNewton(const int2048 &, const int2048 &, int2048 &, int2048 &);
+  static int2048 reciprocal(const int2048 &, int);
+  static void divBurnikelZiegler(const int2048 &, const int2048 &, int2048 &, int2048 &);
+  static void divBZ2n1n(const int2048 &, const int2048 &, int, int2048 &, int2048 &);
+  static void divBZ3n2n(const int2048 &, const int2048 &, int, int2048 &, int2048 &);
+  static int2048 limbShift(const int2048 &, int);      // |x| * BASE^k, truncated for k < 0
+  static int2048 limbSlice(const int2048 &, int, int); // limbs [lo, hi) of |x|
+
+  // Radix conversion for binary limbs, in chunks of WIDTH decimal digits,
+  // least significant first.
+  static const int2048 &decimalPower(int);              // 10^(WIDTH * 2^k)
+  static int2048 fromDecimal(const int *, int);         // n chunks -> value
+  static void toDecimal(const int2048 &, int *, int);  // |x| -> 2^k chunks
+  void alignChunks(int); // d: chunks most significant first, the last of t digits
+
+  // Kernels on raw little-endian limb spans. Outputs may alias an input limb
+  // for limb (same starting address).
+  static int limbAdd(int *, const int *, int, const int *, int); // returns carry
+  static int limbSub(int *, const int *, int, const int *, int); // returns borrow
+  static int limbMulSmall(int *, const int *, int, int);         // returns carry
+  static int limbDivSmall(int *, const int *, int, int);         // returns remainder
+  static bool limbAddSigned(int *, const int *, bool, int, const int *, bool, int); // returns sign
+  static long long limbMulAcc(int *, int, const int *, int, const int *, int, bool);  // returns carry
+
+  // Multiplication tiers: out[0, n + m) = a[0, n) * b[0, m), out not aliasing
+  // the inputs; ws is scratch of at least mulScratch(n, m) limbs.
+  static int mulScratch(int, int);
+  static void mulLimbs(int *, const int *, int, const int *, int, int *);
+  static void mulUnbalanced(int *, const int *, int, const int *, int, int *);
+  static void mulSchoolbook(int *, const int *, int, const int *, int);
+  static void sqrSchoolbook(int *, const int *, int);
+  static void mulKaratsuba(int *, const int *, int, const int *, int, int *);
+  static void mulToom3(int *, const int *, int, const int *, int, int *);
+  static void mulNtt(int *, const int *, int, const int *, int);
 
 public:
   // Constructors
@@ -40,6 +153,14 @@ public:
   int2048(long long);
   int2048(const std::string &);
   int2048(const int2048 &);
+  int2048(int2048 &&) noexcept;
+
+  // Lazy sums of products: int2048 r = lazy(a) * b + c - d; builds an
+  // int2048::Sum that refers to its operands and is evaluated into r in one
+  // carry sweep. It has to be consumed in the expression that builds it.
+  class Sum;
+  int2048(const Sum &);
+  friend Sum lazy(const int2048 &);
 
   // The parameter types of the following functions are for reference only, you can choose to use constant references or not
   // If needed, you can add other required functions yourself
@@ -49,9 +170,17 @@ public:
 
   // Read a big integer
   void read(const std::string &);
+  void read(const char *, const char *);
   // Output the stored big integer, no need for newline
   void print();
 
+  // Writes the decimal form into [first, last), without a terminator, and
+  // returns its end, or nullptr if it does not fit; to_chars_bound()
+  // characters are always enough.
+  char *to_chars(char *, char *) const;
+  size_t to_chars_bound() const;
+  std::string to_string() const;
+
   // Add a big integer
   int2048 &add(const int2048 &);
   // Return the sum of two big integers
@@ -70,6 +199,7 @@ public:
   int2048 operator-() const;
 
   int2048 &operator=(const int2048 &);
+  int2048 &operator=(int2048 &&) noexcept;
 
   int2048 &operator+=(const int2048 &);
   friend int2048 operator+(int2048, const int2048 &);
@@ -80,13 +210,37 @@ public:
   int2048 &operator*=(const int2048 &);
   friend int2048 operator*(int2048, const int2048 &);
 
+  // acc += a * b and acc -= a * b, with the product accumulated into acc
+  friend int2048 &addmul(int2048 &, const int2048 &, const int2048 &);
+  friend int2048 &submul(int2048 &, const int2048 &, const int2048 &);
+  friend int2048 &addmul(int2048 &, const int2048 &, long long);
+  friend int2048 &submul(int2048 &, const int2048 &, long long);
+
+  // Square in place; x *= x and x * x take the same path
+  int2048 &square();
+  friend int2048 square(int2048);
+
   int2048 &operator/=(const int2048 &);
   friend int2048 operator/(int2048, const int2048 &);
 
   int2048 &operator%=(const int2048 &);
   friend int2048 operator%(int2048, const int2048 &);
 
+  // Quotient and remainder from a single division, with the floor semantics
+  // of / and %; the outputs may alias the operands
+  friend void divmod(const int2048 &, const int2048 &, int2048 &, int2048 &);
+
+  // Machine-word divisors: a single linear pass, no big divisor is built
+  friend void divmod(const int2048 &, long long, int2048 &, long long &);
+  int2048 &operator/=(long long);
+  friend int2048 operator/(int2048, long long);
+  int2048 &operator%=(long long);
+  friend int2048 operator%(int2048, long long);
+
   friend std::istream &operator>>(std::istream &, int2048 &);
+  // Appends every whitespace-separated token of f to out, parsed in place
+  // from large blocks without going through a stream; returns the count.
+  friend size_t read_all(std::FILE *, std::vector<int2048> &);
   friend std::ostream &operator<<(std::ostream &, const int2048 &);
 
   friend bool operator==(const int2048 &, const int2048 &);
@@ -95,6 +249,108 @@ public:
   friend bool operator>(const int2048 &, const int2048 &);
   friend bool operator<=(const int2048 &, const int2048 &);
   friend bool operator>=(const int2048 &, const int2048 &);
+
+  friend class int2048_accumulator;
+
+  // Limb blocks are recycled through a per-thread pool that caches up to 1 MiB.
+  // While an Arena is alive on a thread every block freed there is kept for
+  // reuse; when the outermost one ends, the whole cache is released at once.
+  class Arena {
+  public:
+    Arena();
+    ~Arena();
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+  };
+};
+
+class int2048::Sum {
+public:
+  friend Sum operator+(Sum, const int2048 &);
+  friend Sum operator-(Sum, const int2048 &);
+  friend Sum operator+(const int2048 &, Sum);
+  friend Sum operator-(const int2048 &, Sum);
+  friend Sum operator+(Sum, const Sum &);
+  friend Sum operator-(Sum, const Sum &);
+  // A lone factor takes the other operand as its second one; anything else
+  // is evaluated first and then multiplied.
+  friend Sum operator*(Sum, const int2048 &);
+  friend Sum operator*(const int2048 &, Sum);
+
+private:
+  static const int MAX_TERMS = 8;
+
+  struct Term {
+    const int2048 *a;
+    const int2048 *b; // nullptr for a plain term
+    bool neg;
+  };
+
+  // A signed term as limbs, or as raw convolution columns when p is null.
+  struct Span {
+    const int *p;
+    const long long *w;
+    int n;
+    bool neg;
+  };
+
+  int2048 acc; // terms already evaluated by collapse()
+  Term t[MAX_TERMS];
+  int count;
+
+  Sum();
+  void push(const int2048 *, const int2048 *, bool);
+  void append(const Sum &, bool);
+  void negate();
+  void mul(const int2048 &);
+  void collapse(); // evaluate everything into acc
+  void evaluate(int2048 &) const;
+  static bool sweep(Limbs &, const Span *, int, int); // returns sign
+
+  friend class int2048;
+  friend Sum lazy(const int2048 &);
+};
+
+// Namespace-scope declarations of the named friends, so that qualified calls
+// such as sjtu::lazy(a) or sjtu::read_all(f, v) find them too.
+int2048 add(int2048, const int2048 &);
+int2048 minus(int2048, const int2048 &);
+int2048::Sum lazy(const int2048 &);
+int2048 &addmul(int2048 &, const int2048 &, const int2048 &);
+int2048 &submul(int2048 &, const int2048 &, const int2048 &);
+int2048 &addmul(int2048 &, const int2048 &, long long);
+int2048 &submul(int2048 &, const int2048 &, long long);
+int2048 square(int2048);
+void divmod(const int2048 &, const int2048 &, int2048 &, int2048 &);
+void divmod(const int2048 &, long long, int2048 &, long long &);
+size_t read_all(std::FILE *, std::vector<int2048> &);
+
+// Sums many values with the carries deferred: += and -= only add limbs into
+// signed 64-bit lanes, which are normalized once by finalize() (or when they
+// run out of headroom).
+class int2048_accumulator {
+public:
+  int2048_accumulator();
+
+  int2048_accumulator &operator+=(const int2048 &);
+  int2048_accumulator &operator-=(const int2048 &);
+  int2048_accumulator &operator+=(long long);
+  int2048_accumulator &operator-=(long long);
+
+  // The sum so far; accumulation can go on afterwards.
+  int2048 finalize();
+  void clear();
+
+private:
+  // Additions a normalized set of lanes takes before it can overflow.
+  static const long long ROOM = 0x7FFFFFFFFFFFFFFFLL / int2048::BASE / 2;
+
+  std::vector<long long> lanes; // little-endian in BASE; the top lane is signed
+  long long room;
+
+  void add(const int *, int, bool);
+  void addWord(unsigned long long, bool);
+  void normalize(); // lanes below the top into [0, BASE)
 };
 } // namespace sjtu
 
@@ -1,7 +1,114 @@
 #include "int2048.h"
 
+#ifdef SJTU_INT2048_THREADS
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
 namespace sjtu {
 
+// Thread-local size-class pool behind the limb storage and the scratch
+// buffers. Class k keeps freed blocks of 2^k bytes on an intrusive free list;
+// larger blocks go straight to operator new. Outside an Arena at most
+// POOL_CACHE bytes stay cached, inside one every freed block does.
+// The pool itself is trivially destructible, so blocks freed after the
+// thread's destructors ran (by a global int2048, say) can still read it;
+// PoolGuard empties it at thread exit and marks it dead.
+struct LimbPool {
+  static const int MIN_CLASS = 5;
+  static const int MAX_CLASS = 20;
+
+  void *head[MAX_CLASS + 1];
+  size_t cached;
+  int scopes;   // live Arena objects on this thread
+  bool guarded; // PoolGuard constructed on this thread
+  bool dead;    // set once PoolGuard is destroyed
+
+  void drain() {
+    for (int k = MIN_CLASS; k <= MAX_CLASS; ++k) {
+      while (head[k]) {
+        void *p = head[k];
+        head[k] = *(void **)p;
+        ::operator delete(p);
+      }
+    }
+    cached = 0;
+  }
+};
+
+static const size_t POOL_CACHE = (size_t)1 << 20;
+static thread_local LimbPool pool;
+
+struct PoolGuard {
+  ~PoolGuard() {
+    pool.drain();
+    pool.dead = true;
+  }
+};
+
+static thread_local PoolGuard poolGuard;
+
+static int poolClass(size_t bytes) {
+  if (bytes <= ((size_t)1 << LimbPool::MIN_CLASS)) return LimbPool::MIN_CLASS;
+  return 64 - __builtin_clzll(bytes - 1);
+}
+
+// Size of the block poolAlloc(bytes) actually returns.
+static size_t poolRound(size_t bytes) {
+  int k = poolClass(bytes);
+  return k <= LimbPool::MAX_CLASS ? (size_t)1 << k : bytes;
+}
+
+static void *poolAlloc(size_t bytes) {
+  int k = poolClass(bytes);
+  if (k > LimbPool::MAX_CLASS) return ::operator new(bytes);
+  void *p = pool.head[k];
+  if (!p) return ::operator new((size_t)1 << k);
+  pool.head[k] = *(void **)p;
+  pool.cached -= (size_t)1 << k;
+  return p;
+}
+
+// bytes is the size passed to poolAlloc or the rounded one.
+static void poolFree(void *p, size_t bytes) {
+  int k = poolClass(bytes);
+  size_t size = (size_t)1 << k;
+  if (k > LimbPool::MAX_CLASS || pool.dead || (!pool.scopes && pool.cached + size > POOL_CACHE)) {
+    ::operator delete(p);
+    return;
+  }
+  if (!pool.guarded) {
+    pool.guarded = true;
+    (void)&poolGuard; // constructs it, so that it drains the pool at exit
+  }
+  *(void **)p = pool.head[k];
+  pool.head[k] = p;
+  pool.cached += size;
+}
+
+// std::vector allocator over the pool, for scratch buffers.
+template <class T> struct PoolAllocator {
+  typedef T value_type;
+
+  PoolAllocator() {}
+  template <class U> PoolAllocator(const PoolAllocator<U> &) {}
+
+  T *allocate(size_t n) { return (T *)poolAlloc(n * sizeof(T)); }
+  void deallocate(T *p, size_t n) { poolFree(p, n * sizeof(T)); }
+
+  template <class U> bool operator==(const PoolAllocator<U> &) const { return true; }
+  template <class U> bool operator!=(const PoolAllocator<U> &) const { return false; }
+};
+
+template <class T> using PoolVector = std::vector<T, PoolAllocator<T>>;
+
+int2048::Arena::Arena() { ++pool.scopes; }
+
+int2048::Arena::~Arena() {
+  if (--pool.scopes == 0) pool.drain();
+}
+
 static long long modPow(long long a, long long e, long long mod) {
   long long r = 1;
   while (e) {
@@ -12,131 +119,781 @@ static long long modPow(long long a, long long e, long long mod) {
   return r;
 }
 
-static void ntt(std::vector<int> &a, bool invert, int mod, int primitiveRoot) {
-  int n = (int)a.size();
-  for (int i = 1, j = 0; i < n; ++i) {
-    int bit = n >> 1;
-    while (j & bit) {
-      j ^= bit;
-      bit >>= 1;
-    }
-    j ^= bit;
-    if (i < j) {
-      int t = a[i];
-      a[i] = a[j];
-      a[j] = t;
-    }
-  }
-
-  for (int len = 2; len <= n; len <<= 1) {
-    long long wlen = modPow(primitiveRoot, (mod - 1) / len, mod);
-    if (invert) wlen = modPow(wlen, mod - 2, mod);
-    for (int i = 0; i < n; i += len) {
-      long long w = 1;
-      int half = len >> 1;
-      for (int j = 0; j < half; ++j) {
-        int u = a[i + j];
-        int v = (int)((__int128)a[i + j + half] * w % mod);
-        int x = u + v;
-        if (x >= mod) x -= mod;
-        int y = u - v;
-        if (y < 0) y += mod;
-        a[i + j] = x;
-        a[i + j + half] = y;
-        w = (long long)((__int128)w * wlen % mod);
+// Montgomery arithmetic modulo an odd prime below 2^30, with R = 2^32.
+// Results are left lazily in [0, 2 * mod): 4 * mod still fits in 32 bits, so
+// the butterflies can add two such values before reducing.
+struct Montgomery {
+  unsigned mod;
+  unsigned mod2; // 2 * mod
+  unsigned nInv; // -mod^-1 mod 2^32
+  unsigned r2;   // R^2 mod mod
+
+  explicit Montgomery(unsigned m) : mod(m), mod2(2 * m) {
+    unsigned inv = m;
+    for (int i = 0; i < 4; ++i) inv *= 2 - m * inv;
+    nInv = 0u - inv;
+    unsigned long long r = (~0ULL % m + 1) % m; // R^2 mod m
+    r2 = (unsigned)r;
+  }
+
+  // t < mod * R  ->  t * R^-1 in [0, 2 * mod)
+  unsigned reduce(unsigned long long t) const {
+    unsigned q = (unsigned)t * nInv;
+    return (unsigned)((t + (unsigned long long)q * mod) >> 32);
+  }
+  unsigned mul(unsigned a, unsigned b) const { return reduce((unsigned long long)a * b); }
+  unsigned toMont(unsigned a) const { return mul(a, r2); }
+  // Brings a lazy value back into [0, mod).
+  unsigned strict(unsigned a) const { return a >= mod ? a - mod : a; }
+};
+
+// Everything ntt() needs for one (size, modulus) pair: the bit-reversal
+// permutation and the twiddles of every stage, in Montgomery form. Stage
+// `len` reads its roots from w[len / 2 .. len), so a butterfly never has to
+// regenerate them.
+struct NttPlan {
+  int n;
+  Montgomery mont;
+  // Applied after the inverse transform: n^-1 * R^2, which also cancels the
+  // R^-1 left behind by the Montgomery pointwise product.
+  unsigned scale;
+  const std::vector<int> *rev; // shared by every modulus of the same size
+  std::vector<unsigned> w;     // forward twiddles
+  std::vector<unsigned> iw;    // inverse twiddles
+
+  NttPlan(int size, unsigned mod) : n(size), mont(mod), scale(0), rev(nullptr) {}
+};
+
+// Plans are built once per thread and kept until it exits: repeated products
+// of similar size hit the same few entries. Each thread has its own cache, so
+// lookups need no lock; worker threads only ever see plans their caller
+// looked up.
+struct NttPlanCache {
+  std::vector<NttPlan *> plans;
+  std::vector<std::vector<int> *> revs;
+
+  ~NttPlanCache() {
+    for (size_t i = 0; i < plans.size(); ++i) delete plans[i];
+    for (size_t i = 0; i < revs.size(); ++i) delete revs[i];
+  }
+};
+
+static thread_local NttPlanCache nttCache;
+
+static const NttPlan &nttPlan(int n, unsigned mod, unsigned primitiveRoot) {
+  std::vector<NttPlan *> &cache = nttCache.plans;
+  for (int i = 0; i < (int)cache.size(); ++i) {
+    if (cache[i]->n == n && cache[i]->mont.mod == mod) return *cache[i];
+  }
+
+  NttPlan *p = new NttPlan(n, mod);
+  cache.push_back(p);
+  const Montgomery &mt = p->mont;
+  p->scale = mt.strict(mt.toMont(mt.toMont((unsigned)modPow(n, mod - 2, mod))));
+  std::vector<std::vector<int> *> &revs = nttCache.revs;
+  for (int i = 0; i < (int)revs.size() && !p->rev; ++i) {
+    if ((int)revs[i]->size() == n) p->rev = revs[i];
+  }
+  if (!p->rev) {
+    std::vector<int> *rev = new std::vector<int>(n, 0);
+    revs.push_back(rev);
+    for (int i = 1; i < n; ++i) (*rev)[i] = ((*rev)[i >> 1] >> 1) | ((i & 1) ? n >> 1 : 0);
+    p->rev = rev;
+  }
+
+  p->w.assign(n, 0);
+  p->iw.assign(n, 0);
+  for (int half = 1; half < n; half <<= 1) {
+    long long wlen = modPow(primitiveRoot, (mod - 1) / (2 * half), mod);
+    long long iwlen = modPow(wlen, mod - 2, mod);
+    long long w = 1, iw = 1;
+    for (int j = 0; j < half; ++j) {
+      p->w[half + j] = mt.strict(mt.toMont((unsigned)w));
+      p->iw[half + j] = mt.strict(mt.toMont((unsigned)iw));
+      w = w * wlen % mod;
+      iw = iw * iwlen % mod;
+    }
+  }
+  return *p;
+}
+
+// With SJTU_INT2048_THREADS, transforms of PARALLEL_NTT_SIZE points and up
+// spread their work over hardwareThreads() threads, at most MAX_THREADS.
+static const int PARALLEL_NTT_SIZE = 1 << 16;
+static const int MAX_THREADS = 64;
+
+static int hardwareThreads() {
+#ifdef SJTU_INT2048_THREADS
+  static const int k = [] {
+    int t = (SJTU_INT2048_THREADS + 0) > 1 ? (SJTU_INT2048_THREADS + 0) : (int)std::thread::hardware_concurrency();
+    return t < 1 ? 1 : t > MAX_THREADS ? MAX_THREADS : t;
+  }();
+  return k;
+#else
+  return 1;
+#endif
+}
+
+#ifdef SJTU_INT2048_THREADS
+// hardwareThreads() - 1 workers, started on first use and kept until exit,
+// sleeping while there is nothing to do. A parallel region posts a job of k
+// tasks; its caller claims tasks too, so a region nested in another one's
+// task always makes progress even with every worker busy.
+struct WorkerPool {
+  struct Job {
+    void (*run)(const void *, int);
+    const void *f;
+    int k;
+    int next;    // first unclaimed task
+    int pending; // tasks not finished yet
+  };
+
+  std::mutex lock;
+  std::condition_variable work, done;
+  std::vector<Job *> open; // jobs with tasks left to claim
+  std::vector<std::thread> workers;
+  bool stop = false;
+
+  explicit WorkerPool(int n) {
+    for (int w = 0; w < n; ++w) workers.emplace_back([this] { serve(); });
+  }
+
+  ~WorkerPool() {
+    {
+      std::lock_guard<std::mutex> g(lock);
+      stop = true;
+    }
+    work.notify_all();
+    for (size_t w = 0; w < workers.size(); ++w) workers[w].join();
+  }
+
+  // With the lock held: the next task of j, closing j once all are claimed.
+  int claim(Job *j) {
+    int t = j->next++;
+    if (j->next == j->k) {
+      for (size_t i = 0; i < open.size(); ++i) {
+        if (open[i] == j) {
+          open.erase(open.begin() + i);
+          break;
+        }
       }
     }
+    return t;
   }
 
-  if (invert) {
-    long long invN = modPow(n, mod - 2, mod);
-    for (int i = 0; i < n; ++i) a[i] = (int)((__int128)a[i] * invN % mod);
+  // Runs task t of j, taking the lock held on entry off for the duration.
+  void execute(std::unique_lock<std::mutex> &g, Job *j, int t) {
+    g.unlock();
+    j->run(j->f, t);
+    g.lock();
+    if (--j->pending == 0) done.notify_all();
+  }
+
+  void serve() {
+    std::unique_lock<std::mutex> g(lock);
+    for (;;) {
+      if (!open.empty()) {
+        Job *j = open.front();
+        execute(g, j, claim(j));
+      } else if (stop) {
+        return;
+      } else {
+        work.wait(g);
+      }
+    }
   }
+
+  void run(Job &j) {
+    std::unique_lock<std::mutex> g(lock);
+    open.push_back(&j);
+    work.notify_all();
+    while (j.next < j.k) execute(g, &j, claim(&j));
+    done.wait(g, [&j] { return j.pending == 0; });
+  }
+};
+
+static WorkerPool &workerPool() {
+  static WorkerPool p(hardwareThreads() - 1);
+  return p;
 }
 
-static std::vector<long long> convolution(const std::vector<int> &a, const std::vector<int> &b) {
-  const int MOD1 = 998244353;
-  const int ROOT1 = 3;
-  const int MOD2 = 1004535809;
-  const int ROOT2 = 3;
+template <class F> static void runTask(const void *f, int t) { (*(const F *)f)(t); }
+#endif
 
-  int n = 1;
-  while (n < (int)a.size() + (int)b.size()) n <<= 1;
+// Runs f(0) .. f(k - 1), on the worker pool as well as the calling thread
+// when `threads` > 1.
+template <class F> static void parallelFor(int k, int threads, const F &f) {
+#ifdef SJTU_INT2048_THREADS
+  if (threads > 1 && k > 1) {
+    WorkerPool::Job j = {runTask<F>, &f, k, 0, k};
+    workerPool().run(j);
+    return;
+  }
+#endif
+  (void)threads;
+  for (int t = 0; t < k; ++t) f(t);
+}
 
-  std::vector<int> x1(n, 0), y1(n, 0), x2(n, 0), y2(n, 0);
-  for (int i = 0; i < (int)a.size(); ++i) {
-    x1[i] = a[i] % MOD1;
-    x2[i] = a[i] % MOD2;
+// One radix-2 stage over a[0, n): butterflies j in [jlo, jhi) of every block.
+static void nttStageScalar(unsigned *a, int n, int half, const unsigned *w, const Montgomery &mt, int jlo, int jhi) {
+  unsigned mod2 = mt.mod2;
+  for (int i = 0; i < n; i += 2 * half) {
+    unsigned *lo = a + i;
+    unsigned *hi = lo + half;
+    for (int j = jlo; j < jhi; ++j) {
+      unsigned u = lo[j];
+      unsigned v = mt.mul(hi[j], w[j]);
+      unsigned x = u + v;
+      unsigned y = u + mod2 - v;
+      lo[j] = x >= mod2 ? x - mod2 : x;
+      hi[j] = y >= mod2 ? y - mod2 : y;
+    }
   }
-  for (int i = 0; i < (int)b.size(); ++i) {
-    y1[i] = b[i] % MOD1;
-    y2[i] = b[i] % MOD2;
+}
+
+// x[i] = x[i] * z[i] * R^-1, lazily reduced
+static void nttMulScalar(unsigned *x, const unsigned *z, int lo, int hi, const Montgomery &mt) {
+  for (int i = lo; i < hi; ++i) x[i] = mt.mul(x[i], z[i]);
+}
+
+// x[i] = x[i] * k * R^-1, fully reduced
+static void nttScaleScalar(unsigned *x, unsigned k, int lo, int hi, const Montgomery &mt) {
+  for (int i = lo; i < hi; ++i) x[i] = mt.strict(mt.mul(x[i], k));
+}
+
+// Modular half of Garner's reconstruction from the residues x0, x1, x2
+// modulo m1, m2, m3: x1 becomes t2 = (x1 - x0) / m1 mod m2 and, with a third
+// prime, x2 becomes t3 = (x2 - x0 - m1 * t2) / (m1 * m2) mod m3, all through
+// Montgomery products.
+struct Garner {
+  const Montgomery &mt2, &mt3;
+  unsigned inv12;  // m1^-1 mod m2, in Montgomery form
+  unsigned inv123; // (m1 * m2)^-1 mod m3, in Montgomery form
+  unsigned m1r3;   // m1 mod m3, in Montgomery form
+};
+
+// x0 < m1 < 3 * m3 is first brought below m3, so that x2 + 3 * m3 - x0 -
+// m1 * t2 stays in (0, 4 * m3) and its product with inv123 in range.
+static void garnerScalar(const unsigned *x0, unsigned *x1, unsigned *x2, int lo, int hi, const Garner &g) {
+  unsigned m2 = g.mt2.mod, m3 = g.mt3.mod;
+  for (int i = lo; i < hi; ++i) {
+    unsigned a1 = x0[i];
+    unsigned t2 = g.mt2.strict(g.mt2.mul(x1[i] + m2 - a1, g.inv12));
+    x1[i] = t2;
+    if (x2) {
+      unsigned r = a1 >= m3 ? a1 - m3 : a1;
+      r = r >= m3 ? r - m3 : r;
+      unsigned v = x2[i] + 3 * m3 - r - g.mt3.mul(t2, g.m1r3);
+      x2[i] = g.mt3.strict(g.mt3.mul(v, g.inv123));
+    }
   }
+}
 
-  ntt(x1, false, MOD1, ROOT1);
-  ntt(y1, false, MOD1, ROOT1);
-  ntt(x2, false, MOD2, ROOT2);
-  ntt(y2, false, MOD2, ROOT2);
+// Vector versions of the kernels above for AVX2 and AVX-512, and of the
+// carry chain behind limbAdd() and limbSub() for AVX2, picked by the CPU at
+// run time. They are written with GCC vector extensions; the only
+// instruction spelt out is pmuludq, which multiplies the even 32-bit lanes
+// into 64-bit products, so a Montgomery product handles even and odd lanes
+// separately. Lanes left over at the end go through the scalar loops.
+//
+// The lane templates carry no target of their own: they are always inlined
+// into the entry points below, which do, and only there are they compiled.
+// Declaring the entry points first makes GCC provide the ISA builtins.
+// Vectors only pass through the helpers by reference. A vector returned by
+// value from a function without the AVX target draws -Wpsabi, which GCC
+// reports at the end of the file, out of reach of a scoped pragma; mulEven's
+// builtin calls are the only such returns left, and are reported in place.
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#define SIMD_KERNELS
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+#define SIMD_INLINE inline __attribute__((always_inline))
+#define SIMD_AVX2 __attribute__((target("avx2")))
+#define SIMD_AVX512 __attribute__((target("avx512f")))
+
+struct Garner;
+SIMD_AVX2 static void nttStageAvx2(unsigned *, int, int, const unsigned *, const Montgomery &, int, int);
+SIMD_AVX512 static void nttStageAvx512(unsigned *, int, int, const unsigned *, const Montgomery &, int, int);
+SIMD_AVX2 static void nttMulAvx2(unsigned *, const unsigned *, int, int, const Montgomery &);
+SIMD_AVX512 static void nttMulAvx512(unsigned *, const unsigned *, int, int, const Montgomery &);
+SIMD_AVX2 static void nttScaleAvx2(unsigned *, unsigned, int, int, const Montgomery &);
+SIMD_AVX512 static void nttScaleAvx512(unsigned *, unsigned, int, int, const Montgomery &);
+SIMD_AVX2 static void garnerAvx2(const unsigned *, unsigned *, unsigned *, int, int, const Garner &);
+SIMD_AVX512 static void garnerAvx512(const unsigned *, unsigned *, unsigned *, int, int, const Garner &);
+SIMD_AVX2 static int limbCarryAvx2(int *, const int *, const int *, int, int, int, bool);
+
+template <int L> struct Lanes {
+  typedef unsigned V __attribute__((vector_size(4 * L)));
+  typedef unsigned long long W __attribute__((vector_size(4 * L)));
+  typedef int I __attribute__((vector_size(4 * L)));
+  typedef long long Q __attribute__((vector_size(4 * L)));
+};
+
+static SIMD_INLINE void mulEven(Lanes<8>::W &r, const Lanes<8>::V &a, const Lanes<8>::V &b) {
+  r = (Lanes<8>::W)__builtin_ia32_pmuludq256((Lanes<8>::I)a, (Lanes<8>::I)b);
+}
 
-  for (int i = 0; i < n; ++i) {
-    x1[i] = (int)((__int128)x1[i] * y1[i] % MOD1);
-    x2[i] = (int)((__int128)x2[i] * y2[i] % MOD2);
+static SIMD_INLINE void mulEven(Lanes<16>::W &r, const Lanes<16>::V &a, const Lanes<16>::V &b) {
+  r = (Lanes<16>::W)__builtin_ia32_pmuludq512_mask((Lanes<16>::I)a, (Lanes<16>::I)b, (Lanes<16>::Q){}, (unsigned char)-1);
+}
+
+template <int L> struct MontLanes {
+  typedef typename Lanes<L>::V V;
+  typedef typename Lanes<L>::W W;
+  V mod, mod2, nInv;
+
+  explicit SIMD_INLINE MontLanes(const Montgomery &mt) {
+    mod = (V){} + mt.mod;
+    mod2 = (V){} + mt.mod2;
+    nInv = (V){} + mt.nInv;
   }
 
-  ntt(x1, true, MOD1, ROOT1);
-  ntt(x2, true, MOD2, ROOT2);
+  static SIMD_INLINE void load(V &v, const unsigned *p) { memcpy(&v, p, sizeof v); }
+  static SIMD_INLINE void store(unsigned *p, const V &v) { memcpy(p, &v, sizeof v); }
+  // x -= m where x >= m
+  static SIMD_INLINE void reduce(V &x, const V &m) {
+    V y = x - m;
+    x = y < x ? y : x;
+  }
 
-  long long invMOD1inMOD2 = modPow(MOD1, MOD2 - 2, MOD2);
-  std::vector<long long> c(n);
-  for (int i = 0; i < n; ++i) {
-    long long a1 = x1[i];
-    long long a2 = x2[i];
-    long long t = (a2 - a1) % MOD2;
-    if (t < 0) t += MOD2;
-    t = (long long)((__int128)t * invMOD1inMOD2 % MOD2);
-    c[i] = a1 + (long long)MOD1 * t;
+  // r = a * b * R^-1; r may be a or b.
+  SIMD_INLINE void mul(V &r, const V &a, const V &b) const {
+    W te, to, q, t;
+    mulEven(te, a, b);
+    mulEven(to, (V)((W)a >> 32), (V)((W)b >> 32));
+    mulEven(q, (V)te, nInv);
+    mulEven(t, (V)q, mod);
+    W re = (te + t) >> 32;
+    mulEven(q, (V)to, nInv);
+    mulEven(t, (V)q, mod);
+    W ro = (to + t) & 0xFFFFFFFF00000000ULL;
+    r = (V)(re | ro);
+  }
+};
+
+template <int L>
+static SIMD_INLINE void nttStageLanes(unsigned *a, int n, int half, const unsigned *w, const Montgomery &mt, int jlo, int jhi) {
+  typedef MontLanes<L> M;
+  typedef typename M::V V;
+  M m(mt);
+  for (int i = 0; i < n; i += 2 * half) {
+    unsigned *lo = a + i;
+    unsigned *hi = lo + half;
+    int j = jlo;
+    for (; j + L <= jhi; j += L) {
+      V u, x, y, v;
+      M::load(u, lo + j);
+      M::load(x, hi + j);
+      M::load(y, w + j);
+      m.mul(v, x, y);
+      V s = u + v, d = u + m.mod2 - v;
+      M::reduce(s, m.mod2);
+      M::reduce(d, m.mod2);
+      M::store(lo + j, s);
+      M::store(hi + j, d);
+    }
+    if (j < jhi) nttStageScalar(lo, 2 * half, half, w, mt, j, jhi);
   }
-  return c;
 }
 
-void int2048::trim() {
-  while (!d.empty() && d.back() == 0) d.pop_back();
-  if (d.empty()) sign = false;
+template <int L> static SIMD_INLINE void nttMulLanes(unsigned *x, const unsigned *z, int lo, int hi, const Montgomery &mt) {
+  typedef MontLanes<L> M;
+  typedef typename M::V V;
+  M m(mt);
+  int i = lo;
+  for (; i + L <= hi; i += L) {
+    V u, v;
+    M::load(u, x + i);
+    M::load(v, z + i);
+    m.mul(u, u, v);
+    M::store(x + i, u);
+  }
+  nttMulScalar(x, z, i, hi, mt);
 }
 
-int int2048::absCmp(const int2048 &a, const int2048 &b) {
-  if (a.d.size() != b.d.size()) return a.d.size() < b.d.size() ? -1 : 1;
-  for (int i = (int)a.d.size() - 1; i >= 0; --i) {
-    if (a.d[i] != b.d[i]) return a.d[i] < b.d[i] ? -1 : 1;
+template <int L> static SIMD_INLINE void nttScaleLanes(unsigned *x, unsigned k, int lo, int hi, const Montgomery &mt) {
+  typedef MontLanes<L> M;
+  typedef typename M::V V;
+  M m(mt);
+  V kv = (V){} + k;
+  int i = lo;
+  for (; i + L <= hi; i += L) {
+    V u;
+    M::load(u, x + i);
+    m.mul(u, u, kv);
+    M::reduce(u, m.mod);
+    M::store(x + i, u);
   }
-  return 0;
+  nttScaleScalar(x, k, i, hi, mt);
 }
 
-int2048 int2048::absAdd(const int2048 &a, const int2048 &b) {
-  int2048 c;
-  c.sign = false;
-  int n = (int)a.d.size();
-  int m = (int)b.d.size();
-  int sz = n > m ? n : m;
-  c.d.resize(sz);
-  int carry = 0;
-  for (int i = 0; i < sz; ++i) {
-    int x = i < n ? a.d[i] : 0;
-    int y = i < m ? b.d[i] : 0;
-    int cur = x + y + carry;
-    if (cur >= BASE) {
-      cur -= BASE;
-      carry = 1;
-    } else {
-      carry = 0;
+template <int L>
+static SIMD_INLINE void garnerLanes(const unsigned *x0, unsigned *x1, unsigned *x2, int lo, int hi, const Garner &g) {
+  typedef MontLanes<L> M;
+  typedef typename M::V V;
+  M m2(g.mt2), m3(g.mt3);
+  V inv12 = (V){} + g.inv12, inv123 = (V){} + g.inv123, m1r3 = (V){} + g.m1r3;
+  int i = lo;
+  for (; i + L <= hi; i += L) {
+    V a1, a2, t2;
+    M::load(a1, x0 + i);
+    M::load(a2, x1 + i);
+    m2.mul(t2, a2 + m2.mod - a1, inv12);
+    M::reduce(t2, m2.mod);
+    M::store(x1 + i, t2);
+    if (x2) {
+      V r = a1, a3, p;
+      M::reduce(r, m3.mod);
+      M::reduce(r, m3.mod);
+      M::load(a3, x2 + i);
+      m3.mul(p, t2, m1r3);
+      V v = a3 + 3 * m3.mod - r - p;
+      m3.mul(v, v, inv123);
+      M::reduce(v, m3.mod);
+      M::store(x2 + i, v);
+    }
+  }
+  garnerScalar(x0, x1, x2, i, hi, g);
+}
+
+static void nttStageAvx2(unsigned *a, int n, int half, const unsigned *w, const Montgomery &mt, int jlo, int jhi) {
+  nttStageLanes<8>(a, n, half, w, mt, jlo, jhi);
+}
+static void nttStageAvx512(unsigned *a, int n, int half, const unsigned *w, const Montgomery &mt, int jlo, int jhi) {
+  nttStageLanes<16>(a, n, half, w, mt, jlo, jhi);
+}
+static void nttMulAvx2(unsigned *x, const unsigned *z, int lo, int hi, const Montgomery &mt) {
+  nttMulLanes<8>(x, z, lo, hi, mt);
+}
+static void nttMulAvx512(unsigned *x, const unsigned *z, int lo, int hi, const Montgomery &mt) {
+  nttMulLanes<16>(x, z, lo, hi, mt);
+}
+static void nttScaleAvx2(unsigned *x, unsigned k, int lo, int hi, const Montgomery &mt) {
+  nttScaleLanes<8>(x, k, lo, hi, mt);
+}
+static void nttScaleAvx512(unsigned *x, unsigned k, int lo, int hi, const Montgomery &mt) {
+  nttScaleLanes<16>(x, k, lo, hi, mt);
+}
+static void garnerAvx2(const unsigned *x0, unsigned *x1, unsigned *x2, int lo, int hi, const Garner &g) {
+  garnerLanes<8>(x0, x1, x2, lo, hi, g);
+}
+static void garnerAvx512(const unsigned *x0, unsigned *x1, unsigned *x2, int lo, int hi, const Garner &g) {
+  garnerLanes<16>(x0, x1, x2, lo, hi, g);
+}
+
+// r[0, m) = a + b + cin, or a + (base - 1 - b) + cin with `complement`, in
+// blocks of 64 limbs: the lane-wise sums come first, then the carries of the
+// whole block at once. With G the limbs that generate a carry (sum >= base)
+// and P those that pass one on (sum == base - 1), the carries coming in are
+// ((G << 1 | cin) + P) ^ P. Returns the carry out.
+static int limbCarryAvx2(int *r, const int *a, const int *b, int m, int base, int cin, bool complement) {
+  typedef Lanes<8>::I I;
+  typedef float F __attribute__((vector_size(32)));
+  const I bv = (I){} + base, top = bv - 1, shifts = {0, 1, 2, 3, 4, 5, 6, 7};
+  unsigned long long carry = cin;
+  int i = 0;
+  for (; i + 64 <= m; i += 64) {
+    unsigned long long g = 0, p = 0;
+    for (int k = 0; k < 64; k += 8) {
+      I x, y;
+      memcpy(&x, a + i + k, sizeof x);
+      memcpy(&y, b + i + k, sizeof y);
+      I sum = complement ? x + (top - y) : x + y;
+      memcpy(r + i + k, &sum, sizeof sum);
+      g |= (unsigned long long)(unsigned)__builtin_ia32_movmskps256((F)(sum > top)) << k;
+      p |= (unsigned long long)(unsigned)__builtin_ia32_movmskps256((F)(sum == top)) << k;
+    }
+    unsigned long long x = g << 1 | carry, y = x + p, c = y ^ p;
+    carry = g >> 63 | (y < x);
+    for (int k = 0; k < 64; k += 8) {
+      I sum;
+      memcpy(&sum, r + i + k, sizeof sum);
+      sum += ((I){} + (int)(c >> k & 0xFF)) >> shifts & 1;
+      sum -= (sum > top) & bv;
+      memcpy(r + i + k, &sum, sizeof sum);
+    }
+  }
+  for (; i < m; ++i) {
+    int x = a[i] + (complement ? base - 1 - b[i] : b[i]) + (int)carry;
+    carry = x >= base;
+    r[i] = carry ? x - base : x;
+  }
+  return (int)carry;
+}
+
+// 16 with AVX-512, 8 with AVX2, otherwise 1, at most SJTU_INT2048_SIMD.
+static int simdLanes() {
+  static const int k = [] {
+    __builtin_cpu_init();
+    int lanes = __builtin_cpu_supports("avx512f") ? 16 : __builtin_cpu_supports("avx2") ? 8 : 1;
+#ifdef SJTU_INT2048_SIMD
+    if (lanes > SJTU_INT2048_SIMD) lanes = SJTU_INT2048_SIMD >= 16 ? 16 : SJTU_INT2048_SIMD >= 8 ? 8 : 1;
+#endif
+    return lanes;
+  }();
+  return k;
+}
+
+#pragma GCC diagnostic pop
+#endif
+
+static void nttStage(unsigned *a, int n, int half, const unsigned *w, const Montgomery &mt, int jlo, int jhi) {
+#ifdef SIMD_KERNELS
+  int lanes = simdLanes();
+  if (lanes == 16 && jhi - jlo >= 16) return nttStageAvx512(a, n, half, w, mt, jlo, jhi);
+  if (lanes >= 8 && jhi - jlo >= 8) return nttStageAvx2(a, n, half, w, mt, jlo, jhi);
+#endif
+  nttStageScalar(a, n, half, w, mt, jlo, jhi);
+}
+
+static void nttMul(unsigned *x, const unsigned *z, int lo, int hi, const Montgomery &mt) {
+#ifdef SIMD_KERNELS
+  if (simdLanes() == 16) return nttMulAvx512(x, z, lo, hi, mt);
+  if (simdLanes() == 8) return nttMulAvx2(x, z, lo, hi, mt);
+#endif
+  nttMulScalar(x, z, lo, hi, mt);
+}
+
+static void nttScale(unsigned *x, unsigned k, int lo, int hi, const Montgomery &mt) {
+#ifdef SIMD_KERNELS
+  if (simdLanes() == 16) return nttScaleAvx512(x, k, lo, hi, mt);
+  if (simdLanes() == 8) return nttScaleAvx2(x, k, lo, hi, mt);
+#endif
+  nttScaleScalar(x, k, lo, hi, mt);
+}
+
+static void garner(const unsigned *x0, unsigned *x1, unsigned *x2, int lo, int hi, const Garner &g) {
+#ifdef SIMD_KERNELS
+  if (simdLanes() == 16) return garnerAvx512(x0, x1, x2, lo, hi, g);
+  if (simdLanes() == 8) return garnerAvx2(x0, x1, x2, lo, hi, g);
+#endif
+  garnerScalar(x0, x1, x2, lo, hi, g);
+}
+
+// Input values must lie in [0, 2 * mod); the forward transform leaves its
+// output there too. The inverse transform returns fully reduced values.
+// Split s ways, the stages below n / s work on s independent slices, and
+// each stage above is divided by butterfly index.
+static void ntt(PoolVector<unsigned> &a, bool invert, const NttPlan &plan, int threads = 1) {
+  int n = plan.n;
+  const Montgomery &mt = plan.mont;
+  int s = 1;
+  while (2 * s <= threads && 4LL * s * s <= n) s *= 2;
+  int m = n / s;
+  unsigned *p = a.data();
+  const int *rev = plan.rev->data();
+
+  // Every element takes part in at most one swap, so slices never collide.
+  parallelFor(s, s, [&](int t) {
+    for (int i = t * m; i < (t + 1) * m; ++i) {
+      int j = rev[i];
+      if (i < j) {
+        unsigned x = p[i];
+        p[i] = p[j];
+        p[j] = x;
+      }
+    }
+  });
+
+  const unsigned *roots = invert ? plan.iw.data() : plan.w.data();
+  parallelFor(s, s, [&](int t) {
+    for (int half = 1; half < m; half <<= 1) nttStage(p + t * m, m, half, roots + half, mt, 0, half);
+  });
+  for (int half = m; half < n; half <<= 1) {
+    int part = half / s;
+    parallelFor(s, s, [&](int t) { nttStage(p, n, half, roots + half, mt, t * part, (t + 1) * part); });
+  }
+
+  if (invert) {
+    parallelFor(s, s, [&](int t) { nttScale(p, plan.scale, t * m, (t + 1) * m, mt); });
+  }
+}
+
+// NTT primes below 2^30 sharing the primitive root 3. The first two carry
+// the exact columns while these stay below MOD[0] * MOD[1], which is always
+// the case for 5-digit limbs; 9-digit limbs need the third as well.
+static const unsigned NTT_MOD[3] = {998244353, 1004535809, 469762049};
+static const unsigned NTT_ROOT = 3;
+
+// The columns c[i] of a[0, na) * b[0, nb) for limbs below base: the product
+// is the sum of c[i] * base^i, with every c[i] below 2^61 but not normalised.
+// Passing the same span twice squares it with one forward transform per prime.
+// When one operand is much the longer, it is cut into slices that each share
+// a small transform with the short one, whose transform is computed once.
+template <long long base>
+static PoolVector<long long> convolution(const int *a, int na, const int *b, int nb) {
+  bool square = a == b && na == nb;
+  if (na < nb) {
+    const int *t = a;
+    a = b;
+    b = t;
+    int k = na;
+    na = nb;
+    nb = k;
+  }
+
+  // A slice of len limbs needs a transform of n >= len + nb points, leaving
+  // a spare column on top for the three-prime split below. Slicing costs two
+  // transforms per slice against three for the whole product.
+  int n = 1;
+  while (n < na + nb) n <<= 1;
+  int len = na;
+  if (!square) {
+    int lg = 0;
+    while ((1 << lg) < n) ++lg;
+    long long best = 3LL * n * lg;
+    for (int s = 1, k = 0; s < n; s <<= 1, ++k) {
+      if (s < 2 * nb) continue;
+      int slices = (na + s - nb - 1) / (s - nb);
+      long long cost = (2LL * slices + 1) * s * k;
+      if (cost < best) {
+        best = cost;
+        n = s;
+        len = s - nb;
+      }
+    }
+  }
+
+  __int128 bound = (__int128)(base - 1) * (base - 1) * nb;
+  int primes = bound < (__int128)NTT_MOD[0] * NTT_MOD[1] ? 2 : 3;
+
+  // The primes are independent and run side by side when threads are
+  // available, sharing them out for their transforms. Plans are looked up
+  // first, as the cache is not to be touched concurrently.
+  int threads = n >= PARALLEL_NTT_SIZE ? hardwareThreads() : 1;
+  int share = threads / primes > 1 ? threads / primes : 1;
+  const NttPlan *plans[3];
+  for (int k = 0; k < primes; ++k) plans[k] = &nttPlan(n, NTT_MOD[k], NTT_ROOT);
+
+  // Limbs are below 4 * mod for each prime, so one conditional subtraction
+  // brings them into the lazy [0, 2 * mod) range the transforms accept.
+  auto load = [&](PoolVector<unsigned> &x, const int *p, int k, unsigned mod2) {
+    x.assign(n, 0);
+    for (int i = 0; i < k; ++i) x[i] = (unsigned)p[i] >= mod2 ? (unsigned)p[i] - mod2 : (unsigned)p[i];
+  };
+  PoolVector<unsigned> x[3], y[3];
+  if (!square) {
+    parallelFor(primes, threads, [&](int k) {
+      load(y[k], b, nb, plans[k]->mont.mod2);
+      ntt(y[k], false, *plans[k], share);
+    });
+  }
+
+  // Garner: c = a1 + m1 * t2 (+ m1 * m2 * t3) with
+  //   t2 = (a2 - a1) / m1 mod m2,  t3 = (a3 - a1 - m1 * t2) / (m1 * m2) mod m3,
+  // which garner() leaves in x[1] and x[2].
+  const unsigned m1 = NTT_MOD[0], m2 = NTT_MOD[1], m3 = NTT_MOD[2];
+  const Montgomery &mt2 = plans[1]->mont, &mt3 = plans[primes - 1]->mont;
+  Garner g = {mt2, mt3, mt2.toMont((unsigned)modPow(m1, m2 - 2, m2)), 0, 0};
+  if (primes == 3) {
+    g.inv123 = mt3.toMont((unsigned)modPow((long long)m1 * m2 % m3, m3 - 2, m3));
+    g.m1r3 = mt3.toMont(m1 % m3);
+  }
+
+  // With three primes a column can reach about base^2 * nb, too much for 64
+  // bits. Writing A = t2 + m2 * t3 = Ah * base + Al, the column is
+  // (a1 + m1 * Al) + base * (m1 * Ah), and the second part moves up into the
+  // next column. Both parts stay below 2^60. A slice starting at lo
+  // recomputes column lo - 1 for the part it receives.
+  auto column = [&](int i, unsigned long long &ah) {
+    unsigned long long A = x[1][i] + (unsigned long long)m2 * x[2][i];
+    ah = A / base;
+    return (long long)(x[0][i] + (unsigned long long)m1 * (A - ah * base));
+  };
+
+  int total = na + nb;
+  PoolVector<long long> c(total);
+  for (int off = 0; off < na; off += len) {
+    int k = na - off < len ? na - off : len;
+    parallelFor(primes, threads, [&](int p) {
+      const NttPlan &plan = *plans[p];
+      load(x[p], a + off, k, plan.mont.mod2);
+      ntt(x[p], false, plan, share);
+      nttMul(x[p].data(), square ? x[p].data() : y[p].data(), 0, n, plan.mont);
+      ntt(x[p], true, plan, share);
+    });
+    unsigned *x2 = primes == 3 ? x[2].data() : nullptr;
+    parallelFor(threads, threads, [&](int t) {
+      garner(x[0].data(), x[1].data(), x2, (int)((long long)n * t / threads), (int)((long long)n * (t + 1) / threads), g);
+    });
+
+    // Columns [off, off + nb) already hold the top of the previous slice.
+    // The two are added and split at base, the high part moving up a column,
+    // so that the sums stay within the bound of a single product.
+    int cols = total - off < n ? total - off : n;
+    long long *r = c.data() + off;
+    parallelFor(threads, threads, [&](int t) {
+      int lo = (int)((long long)cols * t / threads), hi = (int)((long long)cols * (t + 1) / threads);
+      if (primes == 2) {
+        for (int i = lo; i < hi; ++i) r[i] += x[0][i] + (long long)m1 * x[1][i];
+        return;
+      }
+      unsigned long long ah = 0;
+      if (lo > 0) column(lo - 1, ah);
+      for (int i = lo; i < hi; ++i) {
+        long long up = (long long)(m1 * ah);
+        r[i] += column(i, ah) + up;
+      }
+    });
+    if (off) {
+      for (int i = 0; i < nb; ++i) {
+        long long hi = r[i] / base;
+        r[i] -= hi * base;
+        r[i + 1] += hi;
+      }
     }
-    c.d[i] = cur;
   }
-  if (carry) c.d.push_back(carry);
-  c.trim();
   return c;
 }
 
+// Below KARATSUBA_THRESHOLD limbs (of the shorter operand) schoolbook wins;
+// Toom-3 takes over from Karatsuba at TOOM3_THRESHOLD and the NTT beyond
+// NTT_THRESHOLD, which comes later for 9-digit and binary limbs as their
+// products need three primes.
+static const int KARATSUBA_THRESHOLD = 24;
+static const int TOOM3_THRESHOLD = 150;
+#ifdef SJTU_INT2048_BINARY
+static const int NTT_THRESHOLD = 800;
+#else
+static const int NTT_THRESHOLD = SJTU_INT2048_WIDTH == 9 ? 800 : 400;
+#endif
+
+// Division goes recursive (Burnikel-Ziegler) once both the divisor and the
+// quotient reach BZ_THRESHOLD limbs, and switches to Newton reciprocals from
+// NEWTON_THRESHOLD. BZ blocks and reciprocals of up to BZ_BASECASE and
+// NEWTON_BASECASE limbs are done by long division.
+static const int BZ_THRESHOLD = 200;
+static const int BZ_BASECASE = 80;
+static const int NEWTON_THRESHOLD = 16000;
+static const int NEWTON_BASECASE = 32;
+
+// Radix conversion splits down to CONVERT_BASECASE chunks of WIDTH digits,
+// which are then converted one chunk at a time.
+static const int CONVERT_BASECASE = 64;
+
+// From the top, passing over equal runs of eight limbs one block at a time.
+static int limbCmp(const int *a, const int *b, int n) {
+  while (n >= 8 && !memcmp(a + n - 8, b + n - 8, 8 * sizeof(int))) n -= 8;
+  for (int i = n - 1; i >= 0; --i) {
+    if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+  }
+  return 0;
+}
+
+static void limbZero(int *r, int n) { std::memset(r, 0, sizeof(int) * n); }
+
+void int2048::trim() {
+  while (!d.empty() && d.back() == 0) d.pop_back();
+  if (d.empty()) sign = false;
+}
+
+int int2048::absCmp(const int2048 &a, const int2048 &b) {
+  if (a.d.size() != b.d.size()) return a.d.size() < b.d.size() ? -1 : 1;
+  return limbCmp(a.d.data(), b.d.data(), (int)a.d.size());
+}
+
 int2048 int2048::absSub(const int2048 &a, const int2048 &b) {
   int2048 c;
   c.sign = false;
@@ -178,7 +935,262 @@ int2048 int2048::absMulInt(const int2048 &a, int m) {
   return c;
 }
 
+// |a| / b for b <= ~0ULL / BASE, so that rem * BASE + limb fits in 64 bits:
+// one pass from the top limb. q may alias a; returns the remainder.
+unsigned long long int2048::absDivInt(const int2048 &a, unsigned long long b, int2048 &q) {
+  Limbs res(a.d.size());
+  unsigned long long rem = 0;
+  for (int i = (int)a.d.size() - 1; i >= 0; --i) {
+    unsigned long long cur = rem * BASE + (unsigned)a.d[i];
+    res[i] = (int)(cur / b);
+    rem = cur % b;
+  }
+  q.sign = false;
+  q.d.swap(res);
+  q.trim();
+  return rem;
+}
+
 void int2048::divModAbs(const int2048 &a, const int2048 &b, int2048 &q, int2048 &r) {
+  int n = (int)a.d.size();
+  int m = (int)b.d.size();
+  if (m * WIDTH <= 18) {
+    unsigned long long v = 0;
+    for (int i = m - 1; i >= 0; --i) v = v * BASE + b.d[i];
+    if (v && v <= ~0ULL / BASE) {
+      r = int2048((long long)absDivInt(a, v, q));
+      return;
+    }
+  }
+  if (m >= NEWTON_THRESHOLD && n - m >= NEWTON_THRESHOLD) {
+    divNewton(a, b, q, r);
+  } else if (m >= BZ_THRESHOLD && n - m >= BZ_THRESHOLD) {
+    divBurnikelZiegler(a, b, q, r);
+  } else {
+    divSchoolbook(a, b, q, r);
+  }
+}
+
+int2048 int2048::limbSlice(const int2048 &x, int lo, int hi) {
+  int2048 r;
+  if (hi > (int)x.d.size()) hi = (int)x.d.size();
+  if (lo < hi) {
+    r.d.assign(x.d.begin() + lo, x.d.begin() + hi);
+    r.trim();
+  }
+  return r;
+}
+
+int2048 int2048::limbShift(const int2048 &x, int k) {
+  int2048 r;
+  if (k >= 0) {
+    if (x.d.empty()) return r;
+    r.d.assign(k + x.d.size(), 0);
+    memcpy(r.d.data() + k, x.d.data(), sizeof(int) * x.d.size());
+  } else if (-k < (int)x.d.size()) {
+    r.d.assign(x.d.begin() - k, x.d.end());
+  }
+  return r;
+}
+
+// Powers are built once by repeated squaring and kept per thread, like the
+// NTT plans. They are held by value: 2^k chunks fit an int for k < 32, so the
+// array never has to grow and the references handed out stay valid.
+const int2048 &int2048::decimalPower(int k) {
+  static thread_local int2048 cache[32];
+  static thread_local int count = 0;
+  if (!count) cache[count++] = int2048(CHUNK);
+  while (count <= k) {
+    cache[count] = cache[count - 1];
+    cache[count].square();
+    ++count;
+  }
+  return cache[k];
+}
+
+// The top chunks are scaled by 10^(WIDTH * 2^k) for the largest 2^k < n and
+// added onto the bottom 2^k, all on top of the fast multiplication.
+int2048 int2048::fromDecimal(const int *c, int n) {
+  int2048 r;
+  if (n <= CONVERT_BASECASE) {
+    for (int i = n - 1; i >= 0; --i) {
+      int carry = limbMulSmall(r.d.data(), r.d.data(), (int)r.d.size(), CHUNK);
+      if (carry) r.d.push_back(carry);
+      if (r.d.empty()) {
+        if (c[i]) r.d.push_back(c[i]);
+      } else if (limbAdd(r.d.data(), r.d.data(), (int)r.d.size(), c + i, 1)) {
+        r.d.push_back(1);
+      }
+    }
+    return r;
+  }
+
+  int k = 0;
+  while ((2 << k) < n) ++k;
+  int h = 1 << k;
+  const int2048 &p = decimalPower(k);
+  r = fromDecimal(c, h);
+  addmul(r, fromDecimal(c + h, n - h), p);
+  return r;
+}
+
+// Writes exactly 2^k chunks of |x| < 10^(WIDTH * 2^k): one division by the
+// power at the middle splits the work into two halves.
+void int2048::toDecimal(const int2048 &x, int *out, int k) {
+  int n = 1 << k;
+  if (n <= CONVERT_BASECASE) {
+    Limbs t(x.d);
+    int len = (int)t.size();
+    for (int i = 0; i < n; ++i) {
+      out[i] = len ? limbDivSmall(t.data(), t.data(), len, CHUNK) : 0;
+      while (len && !t[len - 1]) --len;
+    }
+    return;
+  }
+
+  int2048 q, r;
+  divModAbs(x, decimalPower(k - 1), q, r);
+  toDecimal(r, out, k - 1);
+  toDecimal(q, out + n / 2, k - 1);
+}
+
+// Newton iteration x <- x + x * (BASE^2p - b * x) / BASE^2p, started from the
+// reciprocal of the top h ~ p / 2 limbs of b so that every step doubles the
+// number of correct limbs. The result may be a few units off.
+int2048 int2048::reciprocal(const int2048 &b, int p) {
+  if (p <= NEWTON_BASECASE) {
+    int2048 q, r;
+    divSchoolbook(limbShift(int2048(1), 2 * p), b, q, r);
+    return q;
+  }
+  int h = p / 2 + 2;
+  int2048 y = reciprocal(limbShift(b, h - p), h);
+  // With x0 = y * BASE^(p - h) the update reduces to y * e / BASE^2h.
+  int2048 e = limbShift(int2048(1), p + h);
+  e -= b * y;
+  int2048 x = limbShift(y, p - h);
+  int2048 t = y * e;
+  bool neg = t.sign;
+  t = limbShift(t, -2 * h);
+  if (neg) {
+    x -= t;
+  } else {
+    x += t;
+  }
+  return x;
+}
+
+// Quotient from a reciprocal of b carried to p = (quotient limbs) + 2 limbs of
+// precision: both operands are shifted so that b has exactly p limbs, which
+// keeps the estimate within a couple of units; the remainder fixes it up.
+void int2048::divNewton(const int2048 &a, const int2048 &b, int2048 &q, int2048 &r) {
+  int n = (int)a.d.size();
+  int m = (int)b.d.size();
+  int p = n - m + 3;
+  int shift = p - m;
+  int2048 x = reciprocal(limbShift(b, shift), p);
+  x *= limbShift(a, shift);
+  q = limbShift(x, -2 * p);
+
+  int2048 bAbs = limbShift(b, 0);
+  r = limbShift(a, 0);
+  r -= q * bAbs;
+  while (r.sign) {
+    q -= int2048(1);
+    r += bAbs;
+  }
+  while (absCmp(r, bAbs) >= 0) {
+    q += int2048(1);
+    r -= bAbs;
+  }
+}
+
+// Burnikel-Ziegler recursive division. The divisor is scaled so that its top
+// limb is at least BASE / 2 and padded to n = j * 2^k limbs with
+// j <= BZ_BASECASE; the dividend is then consumed in n-limb blocks, each step
+// dividing a 2n-limb window by the n-limb divisor.
+void int2048::divBurnikelZiegler(const int2048 &a, const int2048 &b, int2048 &q, int2048 &r) {
+  int m = (int)b.d.size();
+  int j = m, k = 0;
+  while (j > BZ_BASECASE) {
+    j = (j + 1) / 2;
+    ++k;
+  }
+  int n = j << k;
+  int f = BASE / (b.d.back() + 1);
+  int2048 bn = limbShift(absMulInt(b, f), n - m);
+  int2048 an = limbShift(absMulInt(a, f), n - m);
+  // One spare limb keeps the top block below BASE^(n - 1) <= bn.
+  int t = ((int)an.d.size() + n) / n;
+  if (t < 2) t = 2;
+
+  q = int2048(0);
+  q.d.assign(t * n, 0);
+  int2048 z = limbSlice(an, (t - 2) * n, t * n);
+  for (int i = t - 2; i >= 0; --i) {
+    int2048 qi;
+    divBZ2n1n(z, bn, n, qi, r);
+    for (int l = 0; l < (int)qi.d.size(); ++l) q.d[i * n + l] = qi.d[l];
+    if (i > 0) {
+      z = limbShift(r, n);
+      z += limbSlice(an, (i - 1) * n, i * n);
+    }
+  }
+  q.trim();
+
+  r = limbShift(r, m - n);
+  limbDivSmall(r.d.data(), r.d.data(), (int)r.d.size(), f);
+  r.trim();
+}
+
+// a < b * BASE^n with b normalised and n limbs long: split into two 3/2 steps.
+void int2048::divBZ2n1n(const int2048 &a, const int2048 &b, int n, int2048 &q, int2048 &r) {
+  if ((n & 1) || n <= BZ_BASECASE) {
+    divSchoolbook(a, b, q, r);
+    return;
+  }
+  int h = n / 2;
+  int2048 q1, q2, t;
+  divBZ3n2n(limbShift(a, -h), b, h, q1, t);
+  t = limbShift(t, h);
+  t += limbSlice(a, 0, h);
+  divBZ3n2n(t, b, h, q2, r);
+  q = limbShift(q1, h);
+  q += q2;
+}
+
+// a has at most 3h limbs and a < b * BASE^h, where b = b1 * BASE^h + b2 is
+// normalised with 2h limbs. The quotient estimated from the top two thirds is
+// at most two too large.
+void int2048::divBZ3n2n(const int2048 &a, const int2048 &b, int h, int2048 &q, int2048 &r) {
+  int2048 a12 = limbShift(a, -h);
+  int2048 b1 = limbShift(b, -h);
+  int2048 r1;
+  if (absCmp(limbShift(a, -2 * h), b1) < 0) {
+    divBZ2n1n(a12, b1, h, q, r1);
+  } else {
+    // a1 == b1: q = BASE^h - 1 and r1 = a12 - q * b1
+    q = limbShift(int2048(1), h);
+    q -= int2048(1);
+    r1 = a12;
+    r1 -= limbShift(b1, h);
+    r1 += b1;
+  }
+  r = limbShift(r1, h);
+  r += limbSlice(a, 0, h);
+  r -= q * limbSlice(b, 0, h);
+  while (r.sign) {
+    q -= int2048(1);
+    r += b;
+  }
+}
+
+// Knuth's Algorithm D (TAOCP 4.3.1). Both operands are scaled by
+// f = BASE / (top + 1) so that the divisor's top limb is at least BASE / 2;
+// a quotient limb estimated from the top two limbs of the window and of the
+// divisor is then at most one too large after the qhat * v[m - 2] test. The
+// dividend is reduced in place, one window u[j, j + m] at a time.
+void int2048::divSchoolbook(const int2048 &a, const int2048 &b, int2048 &q, int2048 &r) {
   q = int2048(0);
   r = int2048(0);
   if (b.d.empty()) return; // undefined by spec
@@ -188,77 +1200,567 @@ void int2048::divModAbs(const int2048 &a, const int2048 &b, int2048 &q, int2048
     return;
   }
 
-  q.sign = false;
-  q.d.assign(a.d.size(), 0);
-  r.sign = false;
-  r.d.clear();
+  int n = (int)a.d.size();
+  int m = (int)b.d.size();
+  q.d.assign(n - m + 1, 0);
+  if (m == 1) {
+    int rem = limbDivSmall(q.d.data(), a.d.data(), n, b.d[0]);
+    q.trim();
+    if (rem) r.d.push_back(rem);
+    return;
+  }
+
+  int f = BASE / (b.d.back() + 1);
+  PoolVector<int> u(n + 1), v(m);
+  u[n] = limbMulSmall(u.data(), a.d.data(), n, f);
+  limbMulSmall(v.data(), b.d.data(), m, f);
+
+  long long v1 = v[m - 1];
+  long long v2 = v[m - 2];
+  for (int j = n - m; j >= 0; --j) {
+    int *w = u.data() + j;
+    long long num = 1LL * w[m] * BASE + w[m - 1];
+    long long qhat = num / v1;
+    long long rhat = num % v1;
+    while (qhat >= BASE || qhat * v2 > rhat * BASE + w[m - 2]) {
+      --qhat;
+      rhat += v1;
+      if (rhat >= BASE) break;
+    }
+
+    long long carry = 0;
+    int borrow = 0;
+    for (int i = 0; i < m; ++i) {
+      long long p = qhat * v[i] + carry;
+      carry = p / BASE;
+      int x = w[i] - (int)(p % BASE) - borrow;
+      borrow = x < 0;
+      w[i] = borrow ? x + BASE : x;
+    }
+    long long top = w[m] - carry - borrow;
+    if (top < 0) {
+      // qhat was one too large: add the divisor back.
+      --qhat;
+      top += limbAdd(w, w, m, v.data(), m);
+    }
+    w[m] = (int)top;
+    q.d[j] = (int)qhat;
+  }
+  q.trim();
+
+  r.d.assign(m, 0);
+  limbDivSmall(r.d.data(), u.data(), m, f);
+  r.trim();
+}
+
+int int2048::limbAdd(int *r, const int *a, int n, const int *b, int m) {
+  int carry = 0;
+  int i = 0;
+#ifdef SIMD_KERNELS
+  if (m >= 64 && simdLanes() >= 8) {
+    carry = limbCarryAvx2(r, a, b, m, BASE, 0, false);
+    i = m;
+  }
+#endif
+  for (; i < m; ++i) {
+    int x = a[i] + b[i] + carry;
+    carry = x >= BASE;
+    r[i] = carry ? x - BASE : x;
+  }
+  for (; i < n && carry; ++i) {
+    int x = a[i] + 1;
+    carry = x == BASE;
+    r[i] = carry ? 0 : x;
+  }
+  if (r != a && i < n) memcpy(r + i, a + i, sizeof(int) * (n - i));
+  return carry;
+}
+
+// A vector pass adds the complement of b, plus one, instead.
+int int2048::limbSub(int *r, const int *a, int n, const int *b, int m) {
+  int borrow = 0;
+  int i = 0;
+#ifdef SIMD_KERNELS
+  if (m >= 64 && simdLanes() >= 8) {
+    borrow = 1 - limbCarryAvx2(r, a, b, m, BASE, 1, true);
+    i = m;
+  }
+#endif
+  for (; i < m; ++i) {
+    int x = a[i] - b[i] - borrow;
+    borrow = x < 0;
+    r[i] = borrow ? x + BASE : x;
+  }
+  for (; i < n && borrow; ++i) {
+    int x = a[i] - 1;
+    borrow = x < 0;
+    r[i] = borrow ? BASE - 1 : x;
+  }
+  if (r != a && i < n) memcpy(r + i, a + i, sizeof(int) * (n - i));
+  return borrow;
+}
+
+// r[0, n) = (-1)^aNeg * a[0, n) + (-1)^bNeg * b[0, m) with m <= n; the result
+// must fit in n limbs. Returns whether it is negative.
+bool int2048::limbAddSigned(int *r, const int *a, bool aNeg, int n, const int *b, bool bNeg, int m) {
+  if (aNeg == bNeg) {
+    limbAdd(r, a, n, b, m);
+    return aNeg;
+  }
+  int cmp = 0;
+  for (int i = n - 1; i >= m && !cmp; --i) {
+    if (a[i]) cmp = 1;
+  }
+  if (!cmp) cmp = limbCmp(a, b, m);
+  if (cmp >= 0) {
+    limbSub(r, a, n, b, m);
+    return cmp ? aNeg : false;
+  }
+  limbSub(r, b, m, a, m);
+  limbZero(r + m, n - m);
+  return bNeg;
+}
+
+int int2048::limbMulSmall(int *r, const int *a, int n, int k) {
+  long long carry = 0;
+  for (int i = 0; i < n; ++i) {
+    long long cur = 1LL * a[i] * k + carry;
+    r[i] = (int)(cur % BASE);
+    carry = cur / BASE;
+  }
+  return (int)carry;
+}
+
+int int2048::limbDivSmall(int *r, const int *a, int n, int k) {
+  long long rem = 0;
+  for (int i = n - 1; i >= 0; --i) {
+    long long cur = rem * BASE + a[i];
+    r[i] = (int)(cur / k);
+    rem = cur % k;
+  }
+  return (int)rem;
+}
+
+// Every tier below needs at most about four times its operand length of
+// scratch per level, halving (or thirding) at each step.
+int int2048::mulScratch(int n, int m) { return 6 * (n + m) + 1024; }
+
+void int2048::mulLimbs(int *out, const int *a, int n, const int *b, int m, int *ws) {
+  if (n < m) {
+    const int *t = a;
+    a = b;
+    b = t;
+    int k = n;
+    n = m;
+    m = k;
+  }
+  if (m < KARATSUBA_THRESHOLD) {
+    if (a == b && n == m) {
+      sqrSchoolbook(out, a, n);
+    } else {
+      mulSchoolbook(out, a, n, b, m);
+    }
+  } else if (m >= NTT_THRESHOLD) {
+    mulNtt(out, a, n, b, m);
+  } else if (n >= 2 * m) {
+    mulUnbalanced(out, a, n, b, m, ws);
+  } else if (m >= TOOM3_THRESHOLD && m > 2 * ((n + 2) / 3)) {
+    mulToom3(out, a, n, b, m, ws);
+  } else {
+    mulKaratsuba(out, a, n, b, m, ws);
+  }
+}
+
+// Requires n >= 2m. a is cut into slices of m limbs, each multiplied by b
+// as a balanced product, and the partial products are added in at their
+// offsets, overlapping the previous one by m limbs.
+void int2048::mulUnbalanced(int *out, const int *a, int n, const int *b, int m, int *ws) {
+  int *t = ws;
+  ws += 2 * m;
+  mulLimbs(out, a, m, b, m, ws);
+  limbZero(out + 2 * m, n - m);
+  for (int i = m; i < n; i += m) {
+    int k = n - i < m ? n - i : m;
+    mulLimbs(t, a + i, k, b, m, ws);
+    limbAdd(out + i, out + i, n + m - i, t, k + m);
+  }
+}
+
+// out[0, n + m) = a[0, n) * b[0, m), or with `upper` (b being a) only the
+// products a[i] * a[j] with j > i. Products are summed into 64-bit columns
+// with no division: groups of up to ROWS rows sweep b in tiles of TILE
+// columns, and a column is normalised once, when its tile is done. ROWS is
+// the number of products a column holds on top of a limb and a carry.
+template <long long base>
+static void mulColumns(int *out, const int *a, int n, const int *b, int m, bool upper) {
+  const unsigned long long FIT = (~0ULL - ~0ULL / base - base) / ((unsigned long long)(base - 1) * (base - 1));
+  const int MAX_ROWS = 32;
+  const int ROWS = FIT < MAX_ROWS ? (int)FIT : MAX_ROWS;
+  const int TILE = 256;
+  unsigned long long acc[TILE + MAX_ROWS];
+  memset(acc, 0, sizeof(unsigned long long) * ((m < TILE ? m : TILE) + MAX_ROWS));
+  limbZero(out, n + m);
+
+  for (int i0 = 0; i0 < n; i0 += ROWS) {
+    int r = n - i0 < ROWS ? n - i0 : ROWS;
+    int *o = out + i0; // column i + j of the group
+    unsigned long long carry = 0;
+    int w = 0;
+    for (int j0 = 0; j0 < m; j0 += TILE) {
+      // The r - 1 columns left open by the last tile move to the front.
+      for (int k = 0; w && k < r - 1; ++k) {
+        acc[k] = acc[w + k];
+        acc[w + k] = 0;
+      }
+      w = m - j0 < TILE ? m - j0 : TILE;
+      for (int i = 0; i < r; ++i) {
+        unsigned long long x = (unsigned)a[i0 + i];
+        unsigned long long *col = acc + i;
+        const int *y = b + j0;
+        int j = upper && j0 <= i0 + i ? i0 + i + 1 - j0 : 0;
+        for (; j < w; ++j) col[j] += x * (unsigned)y[j];
+      }
+      for (int k = 0; k < w; ++k) {
+        unsigned long long v = acc[k] + carry + (unsigned)o[j0 + k];
+        acc[k] = 0;
+        carry = v / base;
+        o[j0 + k] = (int)(v - carry * base);
+      }
+    }
+    for (int k = 0; k < r - 1; ++k) {
+      unsigned long long v = acc[w + k] + carry;
+      acc[w + k] = 0;
+      carry = v / base;
+      o[m + k] = (int)(v - carry * base);
+    }
+    o[m + r - 1] = (int)carry;
+  }
+}
+
+void int2048::mulSchoolbook(int *out, const int *a, int n, const int *b, int m) {
+  if (n > m) {
+    mulColumns<BASE>(out, b, m, a, n, false);
+  } else {
+    mulColumns<BASE>(out, a, n, b, m, false);
+  }
+}
+
+// r[0, len) += (-1)^sub * a[0, n) * b[0, m) for len >= n + m, row by row
+// straight into r. Subtracted columns stay above -BASE^2, so adding BASE^2
+// keeps their division unsigned; a row's carry is below BASE in magnitude,
+// so rippling it upwards needs only compares. Returns the signed carry out
+// of r[len - 1].
+long long int2048::limbMulAcc(int *r, int len, const int *a, int n, const int *b, int m, bool sub) {
+  const unsigned long long BIAS = (unsigned long long)BASE * BASE;
+  long long top = 0;
+  for (int i = 0; i < n; ++i) {
+    long long x = a[i];
+    long long carry = 0;
+    if (sub) {
+      for (int j = 0; j < m; ++j) {
+        unsigned long long u = (unsigned long long)(r[i + j] + carry - x * b[j]) + BIAS;
+        unsigned long long q = u / BASE;
+        r[i + j] = (int)(u - q * BASE);
+        carry = (long long)q - BASE;
+      }
+    } else {
+      for (int j = 0; j < m; ++j) {
+        long long cur = r[i + j] + carry + x * b[j];
+        r[i + j] = (int)(cur % BASE);
+        carry = cur / BASE;
+      }
+    }
+    for (int k = i + m; carry && k < len; ++k) {
+      long long cur = r[k] + carry;
+      carry = cur >= BASE ? 1 : (cur < 0 ? -1 : 0);
+      r[k] = (int)(cur - carry * BASE);
+    }
+    top += carry;
+  }
+  return top;
+}
+
+// Squaring: a[0, n) * a[0, n) computing each cross product a_i * a_j once,
+// then doubling and adding the diagonal squares.
+void int2048::sqrSchoolbook(int *out, const int *a, int n) {
+  mulColumns<BASE>(out, a, n, a, n, true);
+  limbAdd(out, out, 2 * n, out, 2 * n);
+  long long carry = 0;
+  for (int i = 0; i < 2 * n; ++i) {
+    long long cur = out[i] + carry;
+    if (!(i & 1)) cur += 1LL * a[i >> 1] * a[i >> 1];
+    out[i] = (int)(cur % BASE);
+    carry = cur / BASE;
+  }
+}
+
+// Split both operands at k = ceil(n / 2):
+//   a * b = z2 * B^2k + ((a0 + a1)(b0 + b1) - z0 - z2) * B^k + z0.
+// Requires n >= m. When b does not reach the split point the two halves of a
+// are multiplied by b separately instead. Squares (a == b) stay squares all
+// the way down.
+void int2048::mulKaratsuba(int *out, const int *a, int n, const int *b, int m, int *ws) {
+  int k = (n + 1) / 2;
+  if (m <= k) {
+    int len = n - k + m;
+    int *t = ws;
+    mulLimbs(out, a, k, b, m, ws);
+    mulLimbs(t, a + k, n - k, b, m, ws + len);
+    limbZero(out + k + m, n - k);
+    limbAdd(out + k, out + k, len, t, len);
+    return;
+  }
+
+  mulLimbs(out, a, k, b, k, ws);
+  mulLimbs(out + 2 * k, a + k, n - k, b + k, m - k, ws);
+
+  int *sa = ws;
+  int *sb = sa + (k + 1);
+  int *z = sb + (k + 1);
+  sa[k] = limbAdd(sa, a, k, a + k, n - k);
+  int la = sa[k] ? k + 1 : k;
+  int lb = la;
+  if (a == b && n == m) {
+    sb = sa;
+  } else {
+    sb[k] = limbAdd(sb, b, k, b + k, m - k);
+    lb = sb[k] ? k + 1 : k;
+  }
+  mulLimbs(z, sa, la, sb, lb, z + 2 * (k + 1));
+  limbZero(z + la + lb, 2 * (k + 1) - la - lb);
+
+  int zn = 2 * (k + 1);
+  limbSub(z, z, zn, out, 2 * k);
+  limbSub(z, z, zn, out + 2 * k, n + m - 2 * k);
+  int rest = n + m - k;
+  limbAdd(out + k, out + k, rest, z, zn < rest ? zn : rest);
+}
+
+// Toom-3 with evaluation points 0, 1, -1, -2 and infinity and Bodrato's
+// interpolation sequence. Operands are split into three parts of k limbs;
+// requires n >= m > 2k. Evaluations at negative points are kept as
+// sign/magnitude pairs.
+void int2048::mulToom3(int *out, const int *a, int n, const int *b, int m, int *ws) {
+  int k = (n + 2) / 3;
+  int L = k + 1;
+  int L2 = 2 * L;
+  int *pa1 = ws, *pam1 = pa1 + L, *pam2 = pam1 + L;
+  int *pb1 = pam2 + L, *pbm1 = pb1 + L, *pbm2 = pbm1 + L;
+  int *r1 = pbm2 + L, *rm1 = r1 + L2, *rm2 = rm1 + L2;
+  int *child = rm2 + L2;
+
+  // p(1) = x0 + x1 + x2, p(-1) = x0 - x1 + x2, p(-2) = x0 - 2 x1 + 4 x2.
+  // tmp must hold two spans of L limbs.
+  auto evaluate = [&](const int *x, int len, int *p1, int *pm1, int *pm2, int *tmp) {
+    int *x1 = tmp;
+    int *x2 = tmp + L;
+    const int *x0 = x;
+    std::memcpy(x1, x + k, sizeof(int) * k);
+    x1[k] = 0;
+    std::memcpy(x2, x + 2 * k, sizeof(int) * (len - 2 * k));
+    limbZero(x2 + (len - 2 * k), L - (len - 2 * k));
+
+    p1[k] = limbAdd(p1, x2, k, x0, k); // x0 + x2, x2[k] == 0
+    bool negM1 = limbAddSigned(pm1, p1, false, L, x1, true, L);
+    limbAdd(p1, p1, L, x1, L);
+
+    limbMulSmall(pm2, x2, L, 4);
+    limbAdd(pm2, pm2, L, x0, k);
+    limbMulSmall(x1, x1, L, 2);
+    bool negM2 = limbAddSigned(pm2, pm2, false, L, x1, true, L);
+    return (negM1 ? 1 : 0) | (negM2 ? 2 : 0);
+  };
+  int sa = evaluate(a, n, pa1, pam1, pam2, r1);
+  int sb = sa;
+  if (a == b && n == m) {
+    pb1 = pa1;
+    pbm1 = pam1;
+    pbm2 = pam2;
+  } else {
+    sb = evaluate(b, m, pb1, pbm1, pbm2, r1);
+  }
+  bool negM1 = ((sa ^ sb) & 1) != 0;
+  bool negM2 = ((sa ^ sb) & 2) != 0;
+
+  int infLen = n + m - 4 * k;
+  const int *rinf = out + 4 * k;
+  mulLimbs(out, a, k, b, k, child);
+  mulLimbs(out + 4 * k, a + 2 * k, n - 2 * k, b + 2 * k, m - 2 * k, child);
+  mulLimbs(r1, pa1, L, pb1, L, child);
+  mulLimbs(rm1, pam1, L, pbm1, L, child);
+  mulLimbs(rm2, pam2, L, pbm2, L, child);
+
+  // r3 = (r(-2) - r(1)) / 3
+  int *r3 = rm2;
+  bool neg3 = limbAddSigned(r3, rm2, negM2, L2, r1, true, L2);
+  limbDivSmall(r3, r3, L2, 3);
+  // r1 = (r(1) - r(-1)) / 2
+  limbAddSigned(r1, r1, false, L2, rm1, !negM1, L2);
+  limbDivSmall(r1, r1, L2, 2);
+  // r2 = r(-1) - r(0)
+  int *r2 = rm1;
+  bool neg2 = limbAddSigned(r2, rm1, negM1, L2, out, true, 2 * k);
+  // r3 = (r2 - r3) / 2 + 2 r(inf)
+  neg3 = limbAddSigned(r3, r2, neg2, L2, r3, !neg3, L2);
+  limbDivSmall(r3, r3, L2, 2);
+  neg3 = limbAddSigned(r3, r3, neg3, L2, rinf, false, infLen);
+  limbAddSigned(r3, r3, neg3, L2, rinf, false, infLen);
+  // r2 = r2 + r1 - r(inf)
+  neg2 = limbAddSigned(r2, r2, neg2, L2, r1, false, L2);
+  limbAddSigned(r2, r2, neg2, L2, rinf, true, infLen);
+  // r1 = r1 - r3
+  limbSub(r1, r1, L2, r3, L2);
+
+  limbZero(out + 2 * k, 2 * k);
+  for (int i = 1; i <= 3; ++i) {
+    const int *c = i == 1 ? r1 : (i == 2 ? r2 : r3);
+    int rest = n + m - i * k;
+    limbAdd(out + i * k, out + i * k, rest, c, L2 < rest ? L2 : rest);
+  }
+}
+
+void int2048::mulNtt(int *out, const int *a, int n, const int *b, int m) {
+  PoolVector<long long> conv = convolution<BASE>(a, n, b, m);
+  int len = n + m;
+  int threads = len >= PARALLEL_NTT_SIZE ? hardwareThreads() : 1;
+
+  // Slices carry independently from zero; their carries are then rippled
+  // into the next slice in order, which rarely goes past a few limbs.
+  long long carries[MAX_THREADS];
+  parallelFor(threads, threads, [&](int t) {
+    long long carry = 0;
+    for (int i = (int)((long long)len * t / threads); i < (int)((long long)len * (t + 1) / threads); ++i) {
+      long long cur = conv[i] + carry;
+      out[i] = (int)(cur % BASE);
+      carry = cur / BASE;
+    }
+    carries[t] = carry;
+  });
+  long long carry = 0;
+  for (int t = 0; t < threads; ++t) {
+    int hi = (int)((long long)len * (t + 1) / threads);
+    for (int i = (int)((long long)len * t / threads); carry && i < hi; ++i) {
+      long long cur = out[i] + carry;
+      out[i] = (int)(cur % BASE);
+      carry = cur / BASE;
+    }
+    carry += carries[t];
+  }
+}
+
+// Rounds k up to the size of the pool block, which the caller keeps as cap.
+int *int2048::Limbs::allocate(size_t &k) {
+  k = poolRound(sizeof(int) * k) / sizeof(int);
+  return (int *)poolAlloc(sizeof(int) * k);
+}
+
+void int2048::Limbs::release(int *q, size_t k) { poolFree(q, sizeof(int) * k); }
+
+int2048::Limbs::Limbs() : p(buf), n(0), cap(INLINE) {}
+
+int2048::Limbs::Limbs(size_t k) : p(buf), n(0), cap(INLINE) { resize(k); }
+
+int2048::Limbs::Limbs(const Limbs &o) : p(buf), n(0), cap(INLINE) {
+  assign(o.begin(), o.end());
+}
+
+int2048::Limbs::Limbs(Limbs &&o) noexcept : p(buf), n(0), cap(INLINE) { swap(o); }
+
+int2048::Limbs::~Limbs() {
+  if (p != buf) release(p, cap);
+}
+
+int2048::Limbs &int2048::Limbs::operator=(const Limbs &o) {
+  if (this != &o) assign(o.begin(), o.end());
+  return *this;
+}
+
+int2048::Limbs &int2048::Limbs::operator=(Limbs &&o) noexcept {
+  swap(o);
+  o.clear();
+  return *this;
+}
+
+size_t int2048::Limbs::size() const { return n; }
+bool int2048::Limbs::empty() const { return n == 0; }
+int *int2048::Limbs::data() { return p; }
+const int *int2048::Limbs::data() const { return p; }
+int *int2048::Limbs::begin() { return p; }
+const int *int2048::Limbs::begin() const { return p; }
+int *int2048::Limbs::end() { return p + n; }
+const int *int2048::Limbs::end() const { return p + n; }
+int &int2048::Limbs::operator[](size_t i) { return p[i]; }
+const int &int2048::Limbs::operator[](size_t i) const { return p[i]; }
+int &int2048::Limbs::back() { return p[n - 1]; }
+const int &int2048::Limbs::back() const { return p[n - 1]; }
+
+void int2048::Limbs::clear() { n = 0; }
+void int2048::Limbs::pop_back() { --n; }
+
+void int2048::Limbs::push_back(int v) {
+  if (n == cap) reserve(2 * (size_t)cap);
+  p[n++] = v;
+}
+
+void int2048::Limbs::reserve(size_t k) {
+  if (k <= cap) return;
+  int *q = allocate(k);
+  memcpy(q, p, sizeof(int) * n);
+  if (p != buf) release(p, cap);
+  p = q;
+  cap = (unsigned)k;
+}
 
-  for (int i = (int)a.d.size() - 1; i >= 0; --i) {
-    if (!r.d.empty()) {
-      r.d.insert(r.d.begin(), a.d[i]);
-    } else if (a.d[i] != 0) {
-      r.d.push_back(a.d[i]);
-    }
-    r.trim();
+void int2048::Limbs::resize(size_t k, int v) {
+  if (k > cap) reserve(k);
+  for (size_t i = n; i < k; ++i) p[i] = v;
+  n = (unsigned)k;
+}
 
-    int ans = 0;
-    if (absCmp(r, b) >= 0) {
-      int m = (int)b.d.size();
-      long long rHi = 0;
-      if ((int)r.d.size() > m) {
-        rHi = 1LL * r.d[m] * BASE + r.d[m - 1];
-      } else {
-        rHi = r.d[m - 1];
-      }
-      long long bHi = b.d[m - 1];
-      ans = (int)(rHi / bHi);
-      if (ans >= BASE) ans = BASE - 1;
-
-      std::vector<int> prod(b.d.size() + 1, 0);
-      auto buildProd = [&](int mul) {
-        long long carry = 0;
-        for (int j = 0; j < (int)b.d.size(); ++j) {
-          long long cur = 1LL * b.d[j] * mul + carry;
-          prod[j] = (int)(cur % BASE);
-          carry = cur / BASE;
-        }
-        prod[b.d.size()] = (int)carry;
-        while (!prod.empty() && prod.back() == 0) prod.pop_back();
-      };
-      auto cmpProdR = [&]() {
-        if (prod.size() != r.d.size()) return prod.size() < r.d.size() ? -1 : 1;
-        for (int k = (int)prod.size() - 1; k >= 0; --k) {
-          if (prod[k] != r.d[k]) return prod[k] < r.d[k] ? -1 : 1;
-        }
-        return 0;
-      };
+void int2048::Limbs::assign(size_t k, int v) {
+  n = 0;
+  resize(k, v);
+}
 
-      buildProd(ans);
-      while (cmpProdR() > 0) {
-        --ans;
-        buildProd(ans);
-      }
-      q.d[i] = ans;
-      if (ans) {
-        int borrow = 0;
-        for (int j = 0; j < (int)r.d.size(); ++j) {
-          int y = j < (int)prod.size() ? prod[j] : 0;
-          int x = r.d[j] - borrow;
-          if (x < y) {
-            x += BASE;
-            borrow = 1;
-          } else {
-            borrow = 0;
-          }
-          r.d[j] = x - y;
-        }
-        r.trim();
-      }
-    }
+void int2048::Limbs::assign(const int *first, const int *last) {
+  size_t k = last - first;
+  n = 0;
+  reserve(k);
+  memcpy(p, first, sizeof(int) * k);
+  n = (unsigned)k;
+}
+
+// Heap blocks trade pointers; an inline buffer has to be copied across.
+void int2048::Limbs::swap(Limbs &o) noexcept {
+  if (this == &o) return;
+  if (p != buf && o.p != o.buf) {
+    int *t = p;
+    p = o.p;
+    o.p = t;
+  } else if (p != buf) {
+    memcpy(buf, o.buf, sizeof(int) * o.n);
+    o.p = p;
+    p = buf;
+  } else if (o.p != o.buf) {
+    memcpy(o.buf, buf, sizeof(int) * n);
+    p = o.p;
+    o.p = o.buf;
+  } else {
+    int t[INLINE];
+    memcpy(t, buf, sizeof(int) * n);
+    memcpy(buf, o.buf, sizeof(int) * o.n);
+    memcpy(o.buf, t, sizeof(int) * n);
   }
+  unsigned t = n;
+  n = o.n;
+  o.n = t;
+  t = cap;
+  cap = o.cap;
+  o.cap = t;
+}
 
-  q.trim();
-  r.trim();
+bool int2048::Limbs::operator==(const Limbs &o) const {
+  return n == o.n && memcmp(p, o.p, sizeof(int) * n) == 0;
 }
 
 int2048::int2048() : sign(false) {}
@@ -283,44 +1785,183 @@ int2048::int2048(const std::string &s) : sign(false) { read(s); }
 
 int2048::int2048(const int2048 &o) : sign(o.sign), d(o.d) {}
 
-void int2048::read(const std::string &s) {
-  sign = false;
-  d.clear();
-  if (s.empty()) return;
+int2048::int2048(int2048 &&o) noexcept : sign(o.sign) {
+  d.swap(o.d);
+  o.sign = false;
+}
 
-  int pos = 0;
-  if (s[0] == '-') {
-    sign = true;
-    pos = 1;
-  } else if (s[0] == '+') {
-    pos = 1;
+// Value of the w decimal digits at p. Eight of them are combined at once as
+// byte lanes of one word: pairs, then quads, then the full eight.
+static int parseDigits(const char *p, int w) {
+  int x = 0;
+  if (w >= 8) {
+    unsigned long long v;
+    memcpy(&v, p, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    v -= 0x3030303030303030ULL;
+    v = (v * 10 + (v >> 8)) & 0x00FF00FF00FF00FFULL;
+    v = (v * 100 + (v >> 16)) & 0x0000FFFF0000FFFFULL;
+    v = (v * 10000 + (v >> 32)) & 0xFFFFFFFFULL;
+    x = (int)v;
+    p += 8;
+    w -= 8;
+  }
+  for (; w > 0; --w) x = x * 10 + (*p++ - '0');
+  return x;
+}
+
+// Length of the run of decimal digits at p, at most n; also eight at a time.
+static int countDigits(const char *p, int n) {
+  const unsigned long long HIGH = 0xF0F0F0F0F0F0F0F0ULL, ZEROS = 0x3030303030303030ULL;
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    unsigned long long v;
+    memcpy(&v, p + i, 8);
+    if ((v & HIGH) != ZEROS || ((v + 0x0606060606060606ULL) & HIGH) != ZEROS) break;
   }
+  while (i < n && p[i] >= '0' && p[i] <= '9') ++i;
+  return i;
+}
+
+static const int POW10[10] = {1,      10,      100,      1000,      10000,
+                              100000, 1000000, 10000000, 100000000, 1000000000};
 
-  while (pos < (int)s.size() && s[pos] == '0') ++pos;
-  if (pos == (int)s.size()) {
+void int2048::read(const std::string &s) { read(s.data(), s.data() + s.size()); }
+
+void int2048::read(const char *first, const char *last) {
+  sign = false;
+  d.clear();
+  if (first != last && (*first == '-' || *first == '+')) sign = *first++ == '-';
+  while (first != last && *first == '0') ++first;
+  if (first == last) {
     sign = false;
     return;
   }
 
-  for (int i = (int)s.size(); i > pos; i -= WIDTH) {
-    int l = i - WIDTH;
-    if (l < pos) l = pos;
-    int x = 0;
-    for (int j = l; j < i; ++j) x = x * 10 + (s[j] - '0');
-    d.push_back(x);
+  // d holds the chunks of WIDTH digits, which are the limbs themselves unless
+  // they still have to be converted to binary.
+  int n = (int)(last - first);
+  int m = (n + WIDTH - 1) / WIDTH;
+  d.resize(m);
+  for (int i = 0; i < m; ++i) {
+    int hi = n - i * WIDTH;
+    int lo = hi > WIDTH ? hi - WIDTH : 0;
+    d[i] = parseDigits(first + lo, hi - lo);
+  }
+  if (BINARY) {
+    bool neg = sign;
+    *this = fromDecimal(d.data(), m);
+    sign = neg;
+  }
+  trim();
+}
+
+// d holds the chunks in reading order, the last one of only t digits: the
+// full ones are reversed into place and the value then shifted by 10^t.
+void int2048::alignChunks(int t) {
+  int m = (int)d.size();
+  int low = d[m - 1];
+  for (int i = 0, j = m - 2; i < j; ++i, --j) {
+    int tmp = d[i];
+    d[i] = d[j];
+    d[j] = tmp;
+  }
+  d.pop_back();
+  if (BINARY) {
+    bool neg = sign;
+    *this = fromDecimal(d.data(), m - 1);
+    sign = neg;
+  }
+
+  int carry = limbMulSmall(d.data(), d.data(), (int)d.size(), POW10[t]);
+  if (carry) d.push_back(carry);
+  if (d.empty()) {
+    d.push_back(low);
+  } else if (limbAdd(d.data(), d.data(), (int)d.size(), &low, 1)) {
+    d.push_back(1);
   }
   trim();
 }
 
 void int2048::print() { std::cout << *this; }
 
+static const char DIGIT_PAIRS[] = "0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+                                  "5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+// Writes exactly w digits of v, zero-padded, ending at end; two at a time.
+static void writeDigits(char *end, unsigned v, int w) {
+  for (; w >= 2; w -= 2) {
+    end -= 2;
+    memcpy(end, DIGIT_PAIRS + 2 * (v % 100), 2);
+    v /= 100;
+  }
+  if (w) *--end = (char)('0' + v);
+}
+
+size_t int2048::to_chars_bound() const {
+  size_t n = d.empty() ? 1 : d.size();
+  // A 30-bit limb carries a little over nine digits.
+  return BINARY ? 10 * n + 2 : WIDTH * n + 1;
+}
+
+char *int2048::to_chars(char *first, char *last) const {
+  if (d.empty()) {
+    if (first == last) return nullptr;
+    *first = '0';
+    return first + 1;
+  }
+
+  const int *c = d.data();
+  int n = (int)d.size();
+  PoolVector<int> chunks;
+  if (BINARY) {
+    int k = 0;
+    while (absCmp(*this, decimalPower(k)) >= 0) ++k;
+    chunks.resize((size_t)1 << k);
+    toDecimal(*this, chunks.data(), k);
+    c = chunks.data();
+    n = (int)chunks.size();
+    while (n > 1 && !c[n - 1]) --n;
+  }
+
+  int topDigits = 1;
+  for (int t = c[n - 1]; t >= 10; t /= 10) ++topDigits;
+  size_t len = (sign ? 1 : 0) + topDigits + (size_t)(n - 1) * WIDTH;
+  if ((size_t)(last - first) < len) return nullptr;
+
+  char *p = first;
+  if (sign) *p++ = '-';
+  p += topDigits;
+  writeDigits(p, c[n - 1], topDigits);
+  for (int i = n - 2; i >= 0; --i) {
+    p += WIDTH;
+    writeDigits(p, c[i], WIDTH);
+  }
+  return p;
+}
+
+std::string int2048::to_string() const {
+  std::string s(to_chars_bound(), '\0');
+  char *end = to_chars(&s[0], &s[0] + s.size());
+  s.resize(end - s.data());
+  return s;
+}
+
 int2048 &int2048::add(const int2048 &o) { return (*this += o); }
 
-int2048 add(int2048 a, const int2048 &b) { return a += b; }
+int2048 add(int2048 a, const int2048 &b) {
+  a += b;
+  return a;
+}
 
 int2048 &int2048::minus(const int2048 &o) { return (*this -= o); }
 
-int2048 minus(int2048 a, const int2048 &b) { return a -= b; }
+int2048 minus(int2048 a, const int2048 &b) {
+  a -= b;
+  return a;
+}
 
 int2048 int2048::operator+() const { return *this; }
 
@@ -338,37 +1979,58 @@ int2048 &int2048::operator=(const int2048 &o) {
   return *this;
 }
 
-int2048 &int2048::operator+=(const int2048 &o) {
-  if (sign == o.sign) {
-    int2048 t = absAdd(*this, o);
-    t.sign = sign;
-    *this = t;
+int2048 &int2048::operator=(int2048 &&o) noexcept {
+  if (this != &o) {
+    sign = o.sign;
+    d.swap(o.d);
+    o.sign = false;
+    o.d.clear();
+  }
+  return *this;
+}
+
+// *this += (negate ? -o : o) directly on d; o may be *this.
+int2048 &int2048::addSigned(const int2048 &o, bool negate) {
+  bool oSign = (o.sign != negate) && !o.d.empty();
+  int n = (int)d.size();
+  int m = (int)o.d.size();
+  if (sign == oSign) {
+    if (n < m) d.resize(m, 0);
+    int carry = limbAdd(d.data(), d.data(), (int)d.size(), o.d.data(), m);
+    if (carry) d.push_back(carry);
+    return *this;
+  }
+
+  int cmp = absCmp(*this, o);
+  if (cmp == 0) {
+    sign = false;
+    d.clear();
+  } else if (cmp > 0) {
+    limbSub(d.data(), d.data(), n, o.d.data(), m);
+    trim();
   } else {
-    int cmp = absCmp(*this, o);
-    if (cmp == 0) {
-      sign = false;
-      d.clear();
-    } else if (cmp > 0) {
-      int2048 t = absSub(*this, o);
-      t.sign = sign;
-      *this = t;
-    } else {
-      int2048 t = absSub(o, *this);
-      t.sign = o.sign;
-      *this = t;
-    }
+    // |o| > |*this|: d = o.d - d, reading each limb of d before overwriting it
+    d.resize(m, 0);
+    limbSub(d.data(), o.d.data(), m, d.data(), m);
+    sign = oSign;
+    trim();
   }
-  trim();
   return *this;
 }
 
-int2048 operator+(int2048 a, const int2048 &b) { return a += b; }
+int2048 &int2048::operator+=(const int2048 &o) { return addSigned(o, false); }
 
-int2048 &int2048::operator-=(const int2048 &o) {
-  return (*this += (-o));
+int2048 operator+(int2048 a, const int2048 &b) {
+  a += b;
+  return a;
 }
 
-int2048 operator-(int2048 a, const int2048 &b) { return a -= b; }
+int2048 &int2048::operator-=(const int2048 &o) { return addSigned(o, true); }
+
+int2048 operator-(int2048 a, const int2048 &b) {
+  a -= b;
+  return a;
+}
 
 int2048 &int2048::operator*=(const int2048 &o) {
   if (d.empty() || o.d.empty()) {
@@ -379,98 +2041,638 @@ int2048 &int2048::operator*=(const int2048 &o) {
 
   int n = (int)d.size();
   int m = (int)o.d.size();
+  // x * x (or x * -x) takes the squaring paths, which recognise a == b.
+  const int *b = (this == &o || d == o.d) ? d.data() : o.d.data();
 
-  std::vector<int> res;
-
-  if ((long long)n * m <= 120000) {
-    res.assign(n + m, 0);
-    for (int i = 0; i < n; ++i) {
-      long long carry = 0;
-      for (int j = 0; j < m || carry; ++j) {
-        long long cur = res[i + j] + carry;
-        if (j < m) cur += 1LL * d[i] * o.d[j];
-        res[i + j] = (int)(cur % BASE);
-        carry = cur / BASE;
-      }
+  Limbs res(n + m);
+  if (m < KARATSUBA_THRESHOLD || n < KARATSUBA_THRESHOLD) {
+    if (b == d.data()) {
+      sqrSchoolbook(res.data(), b, n);
+    } else {
+      mulSchoolbook(res.data(), d.data(), n, b, m);
     }
   } else {
-    std::vector<long long> conv = convolution(d, o.d);
-    res.assign(conv.size() + 2, 0);
+    PoolVector<int> ws(mulScratch(n, m));
+    mulLimbs(res.data(), d.data(), n, b, m, ws.data());
+  }
+
+  d.swap(res);
+  sign = (sign != o.sign);
+  trim();
+  return *this;
+}
+
+int2048 operator*(int2048 a, const int2048 &b) {
+  a *= b;
+  return a;
+}
+
+int2048 &int2048::square() { return (*this *= *this); }
+
+int2048 square(int2048 a) {
+  a.square();
+  return a;
+}
+
+// *this += (-1)^negate * a * b. The product is accumulated into d in place,
+// by the schoolbook rows or by the carry pass over the convolution; only the
+// Karatsuba and Toom-3 tiers go through a product buffer.
+void int2048::mulAcc(const int2048 &a, const int2048 &b, bool negate) {
+  int n = (int)a.d.size();
+  int m = (int)b.d.size();
+  if (!n || !m) return;
+  if (this == &a || this == &b) {
+    *this = negate ? lazy(*this) - lazy(a) * b : lazy(*this) + lazy(a) * b;
+    return;
+  }
+
+  bool pNeg = (a.sign != b.sign) != negate;
+  if (d.empty()) sign = pNeg;
+  bool sub = sign != pNeg;
+  int len = ((int)d.size() > n + m ? (int)d.size() : n + m) + 1;
+  d.resize(len, 0);
+
+  const int *pa = a.d.data();
+  const int *pb = (&a == &b || a.d == b.d) ? pa : b.d.data();
+  if (n < m) {
+    pa = pb;
+    pb = a.d.data();
+    int t = n;
+    n = m;
+    m = t;
+  }
+
+  long long top = 0;
+  if (m < KARATSUBA_THRESHOLD) {
+    // One row per limb of the short operand, each sweeping the long one.
+    top = limbMulAcc(d.data(), len, pb, m, pa, n, sub);
+  } else if (m >= NTT_THRESHOLD) {
+    PoolVector<long long> conv = convolution<BASE>(pa, n, pb, m);
     long long carry = 0;
-    for (int i = 0; i < (int)conv.size(); ++i) {
-      long long cur = conv[i] + carry;
-      res[i] = (int)(cur % BASE);
-      carry = cur / BASE;
-    }
-    int idx = (int)conv.size();
-    while (carry) {
-      if (idx >= (int)res.size()) res.push_back(0);
-      long long cur = res[idx] + carry;
-      res[idx] = (int)(cur % BASE);
+    for (int i = 0; i < len && (i < n + m || carry); ++i) {
+      long long cur = d[i] + carry;
+      if (i < n + m) cur += sub ? -conv[i] : conv[i];
       carry = cur / BASE;
-      ++idx;
+      cur %= BASE;
+      if (cur < 0) {
+        cur += BASE;
+        --carry;
+      }
+      d[i] = (int)cur;
     }
+    top = carry;
+  } else {
+    PoolVector<int> prod(n + m);
+    PoolVector<int> ws(mulScratch(n, m));
+    mulLimbs(prod.data(), pa, n, pb, m, ws.data());
+    sign = limbAddSigned(d.data(), d.data(), sign, len, prod.data(), pNeg, n + m);
   }
 
-  d = res;
-  sign = (sign != o.sign);
+  // A final borrow means the magnitude went below zero: |x| = BASE^len - d.
+  if (top < 0) {
+    int c = 1;
+    for (int i = 0; i < len; ++i) {
+      int v = BASE - 1 - d[i] + c;
+      c = v == BASE;
+      d[i] = c ? 0 : v;
+    }
+    sign = !sign;
+  }
   trim();
-  return *this;
 }
 
-int2048 operator*(int2048 a, const int2048 &b) { return a *= b; }
+int2048 &addmul(int2048 &acc, const int2048 &a, const int2048 &b) {
+  acc.mulAcc(a, b, false);
+  return acc;
+}
 
-int2048 &int2048::operator/=(const int2048 &o) {
-  int2048 a(*this), b(o);
-  a.sign = false;
-  b.sign = false;
+int2048 &submul(int2048 &acc, const int2048 &a, const int2048 &b) {
+  acc.mulAcc(a, b, true);
+  return acc;
+}
 
-  int2048 q, r;
-  divModAbs(a, b, q, r);
+// k fits in the inline limbs, so this allocates nothing on its own.
+int2048 &addmul(int2048 &acc, const int2048 &a, long long k) {
+  acc.mulAcc(a, int2048(k), false);
+  return acc;
+}
+
+int2048 &submul(int2048 &acc, const int2048 &a, long long k) {
+  acc.mulAcc(a, int2048(k), true);
+  return acc;
+}
 
-  bool neg = (sign != o.sign);
-  bool hasRem = !r.d.empty();
+int2048::int2048(const Sum &s) : sign(false) { s.evaluate(*this); }
 
-  q.sign = false;
+int2048::Sum::Sum() : count(0) {}
+
+int2048::Sum lazy(const int2048 &a) {
+  int2048::Sum s;
+  s.push(&a, nullptr, false);
+  return s;
+}
+
+void int2048::Sum::push(const int2048 *a, const int2048 *b, bool neg) {
+  if (count == MAX_TERMS) collapse();
+  t[count].a = a;
+  t[count].b = b;
+  t[count].neg = neg;
+  ++count;
+}
+
+void int2048::Sum::append(const Sum &o, bool neg) {
+  if (!o.acc.d.empty()) {
+    if (neg) {
+      acc -= o.acc;
+    } else {
+      acc += o.acc;
+    }
+  }
+  for (int i = 0; i < o.count; ++i) push(o.t[i].a, o.t[i].b, o.t[i].neg != neg);
+}
+
+void int2048::Sum::negate() {
+  acc.sign = !acc.sign && !acc.d.empty();
+  for (int i = 0; i < count; ++i) t[i].neg = !t[i].neg;
+}
+
+// evaluate() only swaps its result in after the sweep, so acc may be both a
+// term and the destination.
+void int2048::Sum::collapse() {
+  evaluate(acc);
+  count = 0;
+}
+
+void int2048::Sum::mul(const int2048 &b) {
+  if (count == 1 && !t[0].b && acc.d.empty()) {
+    t[0].b = &b;
+    return;
+  }
+  collapse();
+  acc *= b;
+}
+
+// Every term becomes a signed span of limbs; products large enough for the
+// NTT stay as their raw convolution, whose carry normalisation then absorbs
+// all the other terms in the same sweep.
+void int2048::Sum::evaluate(int2048 &out) const {
+  Span sp[MAX_TERMS + 1];
+  PoolVector<int> prod[MAX_TERMS];
+  PoolVector<long long> wide[MAX_TERMS];
+  int k = 0;
+  int len = (int)acc.d.size();
+  bool narrow = true;
+  for (int i = 0; i < count; ++i) {
+    int n = (int)t[i].a->d.size();
+    if (t[i].b && n) n = t[i].b->d.empty() ? 0 : n + (int)t[i].b->d.size();
+    if (n > len) len = n;
+  }
+
+  if (!acc.d.empty()) sp[k++] = {acc.d.data(), nullptr, (int)acc.d.size(), acc.sign};
+  for (int i = 0; i < count; ++i) {
+    const int2048 &a = *t[i].a;
+    int n = (int)a.d.size();
+    if (!n) continue;
+    if (!t[i].b) {
+      sp[k++] = {a.d.data(), nullptr, n, a.sign != t[i].neg};
+      continue;
+    }
+
+    const int2048 &b = *t[i].b;
+    int m = (int)b.d.size();
+    if (!m) continue;
+    bool neg = (a.sign != b.sign) != t[i].neg;
+    const int *pb = (&a == &b || a.d == b.d) ? a.d.data() : b.d.data();
+    // Folding pays off when the product spans most of the columns anyway.
+    // One such product at most, so that the column sums fit in 64 bits.
+    if (narrow && n >= NTT_THRESHOLD && m >= NTT_THRESHOLD && 4 * (n + m) >= 3 * len) {
+      narrow = false;
+      wide[i] = convolution<BASE>(a.d.data(), n, pb, m);
+      sp[k++] = {nullptr, wide[i].data(), n + m, neg};
+    } else {
+      prod[i].resize(n + m);
+      PoolVector<int> ws(n < KARATSUBA_THRESHOLD || m < KARATSUBA_THRESHOLD ? 0 : mulScratch(n, m));
+      mulLimbs(prod[i].data(), a.d.data(), n, pb, m, ws.data());
+      sp[k++] = {prod[i].data(), nullptr, n + m, neg};
+    }
+  }
+  int top = 0;
+  for (int j = 0; j < k; ++j) {
+    if (sp[j].n > sp[top].n) top = j;
+  }
+
+  // k < BASE terms of at most len limbs fit in len + 1.
+  Limbs r(len + 1);
+  bool neg = false;
+  if (narrow) {
+    // Limb spans only: the longest one seeds the result and the others are
+    // added into it in place, without any intermediate int2048. That is one
+    // pass per term, but each runs on the vector carry chain of limbAdd() and
+    // limbSub(); folding them all into sweep() instead measured about 2.4
+    // times slower for eight terms of 10^4 to 10^6 digits.
+    if (k) {
+      memcpy(r.data(), sp[top].p, sizeof(int) * sp[top].n);
+      neg = sp[top].neg;
+    }
+    for (int j = 0; j < k; ++j) {
+      if (j != top) neg = limbAddSigned(r.data(), r.data(), neg, len + 1, sp[j].p, sp[j].neg, sp[j].n);
+    }
+  } else {
+    neg = sweep(r, sp, k, len);
+  }
+  out.d.swap(r);
+  out.sign = neg;
+  out.trim();
+}
+
+// r[0, len] = the sum of the spans, normalised a cache-sized block of columns
+// at a time: each span is added to the block in one tight loop, then a single
+// carry chain divides it out. The bias keeps that chain on non-negative values:
+// u = column + BASE * BIAS + carry and the next carry is u / BASE - BIAS.
+// Returns whether the sum is negative, with r holding its magnitude.
+bool int2048::Sum::sweep(Limbs &r, const Span *sp, int k, int len) {
+  const int BLOCK = 512;
+  const unsigned long long BIAS = (1ULL << 61) / BASE;
+  long long col[BLOCK];
+  unsigned long long q = BIAS;
+  for (int lo = 0; lo < len; lo += BLOCK) {
+    int hi = lo + BLOCK < len ? lo + BLOCK : len;
+    for (int i = 0; i < hi - lo; ++i) col[i] = (long long)(BIAS * (BASE - 1));
+    for (int j = 0; j < k; ++j) {
+      int e = sp[j].n < hi ? sp[j].n : hi;
+      if (sp[j].p) {
+        const int *p = sp[j].p;
+        if (sp[j].neg) {
+          for (int i = lo; i < e; ++i) col[i - lo] -= p[i];
+        } else {
+          for (int i = lo; i < e; ++i) col[i - lo] += p[i];
+        }
+      } else {
+        const long long *w = sp[j].w;
+        if (sp[j].neg) {
+          for (int i = lo; i < e; ++i) col[i - lo] -= w[i];
+        } else {
+          for (int i = lo; i < e; ++i) col[i - lo] += w[i];
+        }
+      }
+    }
+    for (int i = lo; i < hi; ++i) {
+      unsigned long long u = (unsigned long long)col[i - lo] + q;
+      q = u / BASE;
+      r[i] = (int)(u - q * BASE);
+    }
+  }
+
+  long long carry = (long long)(q - BIAS);
+  r.resize(len);
+  while (carry != 0 && carry != -1) {
+    long long cur = carry % BASE;
+    carry /= BASE;
+    if (cur < 0) {
+      cur += BASE;
+      --carry;
+    }
+    r.push_back((int)cur);
+  }
+  if (carry == 0) return false;
+
+  // A final borrow of one means the sum is r - BASE^len: take the complement.
+  int c = 1;
+  for (size_t i = 0; i < r.size(); ++i) {
+    int v = BASE - 1 - r[i] + c;
+    c = v == BASE;
+    r[i] = c ? 0 : v;
+  }
+  if (c) r.push_back(1);
+  return true;
+}
+
+int2048::Sum operator+(int2048::Sum s, const int2048 &b) {
+  s.push(&b, nullptr, false);
+  return s;
+}
+
+int2048::Sum operator-(int2048::Sum s, const int2048 &b) {
+  s.push(&b, nullptr, true);
+  return s;
+}
+
+int2048::Sum operator+(const int2048 &a, int2048::Sum s) {
+  s.push(&a, nullptr, false);
+  return s;
+}
+
+int2048::Sum operator-(const int2048 &a, int2048::Sum s) {
+  s.negate();
+  s.push(&a, nullptr, false);
+  return s;
+}
+
+int2048::Sum operator+(int2048::Sum s, const int2048::Sum &o) {
+  s.append(o, false);
+  return s;
+}
+
+int2048::Sum operator-(int2048::Sum s, const int2048::Sum &o) {
+  s.append(o, true);
+  return s;
+}
+
+int2048::Sum operator*(int2048::Sum s, const int2048 &b) {
+  s.mul(b);
+  return s;
+}
+
+int2048::Sum operator*(const int2048 &a, int2048::Sum s) {
+  s.mul(a);
+  return s;
+}
+
+int2048_accumulator::int2048_accumulator() : room(ROOM) {}
+
+void int2048_accumulator::add(const int *p, int m, bool neg) {
+  if (room == 0) normalize();
+  --room;
+  if (lanes.size() < (size_t)m) lanes.resize(m, 0);
+  long long *l = lanes.data();
   if (neg) {
-    if (hasRem) q += int2048(1);
-    if (!q.d.empty()) q.sign = true;
+    for (int i = 0; i < m; ++i) l[i] -= p[i];
+  } else {
+    for (int i = 0; i < m; ++i) l[i] += p[i];
   }
-  q.trim();
-  *this = q;
+}
+
+void int2048_accumulator::addWord(unsigned long long u, bool neg) {
+  int limb[4];
+  int m = 0;
+  for (; u; u /= int2048::BASE) limb[m++] = (int)(u % int2048::BASE);
+  add(limb, m, neg);
+}
+
+void int2048_accumulator::normalize() {
+  const int BASE = int2048::BASE;
+  room = ROOM;
+  if (lanes.empty()) return;
+  long long carry = 0;
+  size_t top = lanes.size() - 1;
+  for (size_t i = 0; i < top; ++i) {
+    long long v = lanes[i] + carry;
+    carry = v / BASE;
+    v %= BASE;
+    if (v < 0) {
+      v += BASE;
+      --carry;
+    }
+    lanes[i] = v;
+  }
+  lanes[top] += carry;
+
+  // The top lane keeps the sign; split it until it fits in a limb.
+  while (lanes.back() <= -BASE || lanes.back() >= BASE) {
+    long long v = lanes.back();
+    long long q = v / BASE, r = v % BASE;
+    if (r < 0) {
+      r += BASE;
+      --q;
+    }
+    lanes.back() = r;
+    lanes.push_back(q);
+  }
+  while (!lanes.empty() && lanes.back() == 0) lanes.pop_back();
+}
+
+// A negative total is normalized once more as its negation, so that every
+// limb comes out in range, and turned back afterwards.
+int2048 int2048_accumulator::finalize() {
+  normalize();
+  bool neg = !lanes.empty() && lanes.back() < 0;
+  if (neg) {
+    for (size_t i = 0; i < lanes.size(); ++i) lanes[i] = -lanes[i];
+    normalize();
+  }
+
+  int2048 r;
+  r.d.resize(lanes.size());
+  for (size_t i = 0; i < lanes.size(); ++i) r.d[i] = (int)lanes[i];
+  r.sign = neg;
+  r.trim();
+  if (neg) {
+    for (size_t i = 0; i < lanes.size(); ++i) lanes[i] = -lanes[i];
+  }
+  return r;
+}
+
+void int2048_accumulator::clear() {
+  lanes.clear();
+  room = ROOM;
+}
+
+int2048_accumulator &int2048_accumulator::operator+=(const int2048 &x) {
+  add(x.d.data(), (int)x.d.size(), x.sign);
+  return *this;
+}
+
+int2048_accumulator &int2048_accumulator::operator-=(const int2048 &x) {
+  add(x.d.data(), (int)x.d.size(), !x.sign);
+  return *this;
+}
+
+int2048_accumulator &int2048_accumulator::operator+=(long long v) {
+  addWord(v < 0 ? 0ULL - (unsigned long long)v : (unsigned long long)v, v < 0);
+  return *this;
+}
+
+int2048_accumulator &int2048_accumulator::operator-=(long long v) {
+  addWord(v < 0 ? 0ULL - (unsigned long long)v : (unsigned long long)v, v >= 0);
+  return *this;
+}
+
+void divmod(const int2048 &a, const int2048 &b, int2048 &q, int2048 &r) {
+  int2048 qq, rr;
+  int2048::divModAbs(a, b, qq, rr);
+
+  // |a| = qq * |b| + rr; floor division moves a non-zero remainder of a
+  // mixed-sign division across to the divisor's side.
+  bool neg = (a.sign != b.sign);
+  if (neg && !rr.d.empty()) {
+    qq += int2048(1);
+    rr = int2048::absSub(b, rr);
+  }
+  qq.sign = neg && !qq.d.empty();
+  rr.sign = b.sign && !rr.d.empty();
+
+  q.sign = qq.sign;
+  q.d.swap(qq.d);
+  r.sign = rr.sign;
+  r.d.swap(rr.d);
+}
+
+int2048 &int2048::operator/=(const int2048 &o) {
+  int2048 r;
+  divmod(*this, o, *this, r);
   return *this;
 }
 
-int2048 operator/(int2048 a, const int2048 &b) { return a /= b; }
+int2048 operator/(int2048 a, const int2048 &b) {
+  a /= b;
+  return a;
+}
 
 int2048 &int2048::operator%=(const int2048 &o) {
-  int2048 q = (*this) / o;
-  *this -= q * o;
-  trim();
+  int2048 q;
+  divmod(*this, o, q, *this);
+  return *this;
+}
+
+void divmod(const int2048 &a, long long b, int2048 &q, long long &r) {
+  unsigned long long mag = b < 0 ? 0ULL - (unsigned long long)b : (unsigned long long)b;
+  unsigned long long rem = 0;
+  bool neg = (a.sign != (b < 0));
+  if (mag <= ~0ULL / int2048::BASE) {
+    rem = int2048::absDivInt(a, mag, q);
+  } else {
+    int2048 qq, rr;
+    int2048::divModAbs(a, int2048(b), qq, rr);
+    for (int i = (int)rr.d.size() - 1; i >= 0; --i) rem = rem * int2048::BASE + rr.d[i];
+    q.sign = false;
+    q.d.swap(qq.d);
+  }
+
+  if (neg && rem) {
+    q += int2048(1);
+    rem = mag - rem;
+  }
+  q.sign = neg && !q.d.empty();
+  r = b < 0 ? -(long long)rem : (long long)rem;
+}
+
+int2048 &int2048::operator/=(long long o) {
+  long long r;
+  divmod(*this, o, *this, r);
   return *this;
 }
 
-int2048 operator%(int2048 a, const int2048 &b) { return a %= b; }
+int2048 operator/(int2048 a, long long b) {
+  a /= b;
+  return a;
+}
+
+int2048 &int2048::operator%=(long long o) {
+  long long r;
+  divmod(*this, o, *this, r);
+  return *this = int2048(r);
+}
+
+int2048 operator%(int2048 a, long long b) {
+  a %= b;
+  return a;
+}
+
+int2048 operator%(int2048 a, const int2048 &b) {
+  a %= b;
+  return a;
+}
 
+// Digits are taken straight from the stream buffer into the limbs of x; no
+// copy of the text is kept. Whatever is already buffered is pulled a block
+// at a time, and the characters past the number are put back.
 std::istream &operator>>(std::istream &is, int2048 &x) {
-  std::string s;
-  is >> s;
-  x.read(s);
+  const int WIDTH = int2048::WIDTH;
+  const int BLOCK = 256;
+  x.sign = false;
+  x.d.clear();
+  std::istream::sentry ok(is);
+  if (!ok) return is;
+
+  std::streambuf *sb = is.rdbuf();
+  std::ios_base::iostate state = std::ios_base::goodbit;
+  int c = sb->sgetc();
+  if (c == '-' || c == '+') {
+    x.sign = c == '-';
+    c = sb->snextc();
+  }
+  bool any = false;
+  for (; c == '0'; c = sb->snextc()) any = true;
+
+  char buf[BLOCK + WIDTH];
+  int k = 0; // digits in buf not yet forming a chunk
+  while (c >= '0' && c <= '9') {
+    std::streamsize n = sb->in_avail();
+    if (n > BLOCK) n = BLOCK;
+    if (n > 1) {
+      n = sb->sgetn(buf + k, n);
+      int j = k + countDigits(buf + k, (int)n);
+      for (int r = k + (int)n - j; r > 0; --r) {
+        if (sb->sungetc() == std::char_traits<char>::eof()) state |= std::ios_base::badbit;
+      }
+      k = j;
+    } else {
+      // Nothing buffered to look ahead in: a character at a time.
+      for (; k < BLOCK && c >= '0' && c <= '9'; c = sb->snextc()) buf[k++] = (char)c;
+    }
+
+    int i = 0;
+    for (; i + WIDTH <= k; i += WIDTH) x.d.push_back(parseDigits(buf + i, WIDTH));
+    memmove(buf, buf + i, k - i);
+    k -= i;
+    c = sb->sgetc();
+  }
+
+  if (c == std::char_traits<char>::eof()) state |= std::ios_base::eofbit;
+  if (k) x.d.push_back(parseDigits(buf, k));
+  if (!x.d.empty()) {
+    x.alignChunks(k ? k : WIDTH);
+  } else {
+    x.sign = false;
+    if (!any) state |= std::ios_base::failbit;
+  }
+  is.setstate(state);
   return is;
 }
 
-std::ostream &operator<<(std::ostream &os, const int2048 &x) {
-  if (x.d.empty()) {
-    os << '0';
-    return os;
+static bool isSpace(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+// The file is read in large blocks; a token cut by the end of a block is
+// moved to the front and completed by the next one, the buffer doubling if
+// a single token outgrows it.
+size_t read_all(std::FILE *f, std::vector<int2048> &out) {
+  PoolVector<char> buf((size_t)1 << 20);
+  size_t have = 0, count = 0; // have: bytes of an unfinished token at the front
+  bool eof = false;
+  while (!eof) {
+    if (have == buf.size()) buf.resize(2 * buf.size());
+    size_t want = buf.size() - have;
+    size_t got = std::fread(buf.data() + have, 1, want, f);
+    eof = got < want;
+
+    char *p = buf.data(), *end = p + have + got;
+    for (;;) {
+      while (p != end && isSpace(*p)) ++p;
+      char *q = p;
+      while (q != end && !isSpace(*q)) ++q;
+      if (p == q || (q == end && !eof)) break;
+      out.emplace_back();
+      out.back().read(p, q);
+      ++count;
+      p = q;
+    }
+    have = end - p;
+    memmove(buf.data(), p, have);
   }
-  if (x.sign) os << '-';
-  os << x.d.back();
-  char buf[16];
-  for (int i = (int)x.d.size() - 2; i >= 0; --i) {
-    std::snprintf(buf, sizeof(buf), "%05d", x.d[i]);
-    os << buf;
+  return count;
+}
+
+std::ostream &operator<<(std::ostream &os, const int2048 &x) {
+  char local[256];
+  char *buf = local;
+  size_t bound = x.to_chars_bound();
+  PoolVector<char> heap;
+  if (bound > sizeof(local)) {
+    heap.resize(bound);
+    buf = heap.data();
   }
+  char *end = x.to_chars(buf, buf + bound);
+  os.write(buf, end - buf);
   return os;
 }
 